@@ -0,0 +1,249 @@
+#include "archive.h"
+#include "block_format.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define ARCHIVE_HDR_LEN (3 * sizeof(uint64_t))
+
+typedef struct
+{
+    FILE *archiveFile;
+    char *const *inputPaths;
+    size_t count;
+    const BlockEncoderOptions *options;
+    ArchiveDirEntry *entries;
+    atomic_size_t nextMember;
+    atomic_bool failed;
+    pthread_mutex_t writeLock;
+    uint64_t writeOffset;
+} ArchiveJob;
+
+static bool readMemberFile(const char *inputFilePath, struct iovec *input)
+{
+    FILE *inputFile = fopen(inputFilePath, "rb");
+    if (!inputFile)
+    {
+        fprintf(stderr, "%s: Unable to open file: %s (errno: %d)\n", __func__, inputFilePath, errno);
+        return false;
+    }
+    fseek(inputFile, 0, SEEK_END);
+    long len = ftell(inputFile);
+    fseek(inputFile, 0, SEEK_SET);
+    if (len < 0)
+    {
+        fclose(inputFile);
+        return false;
+    }
+
+    input->iov_len = (size_t)len;
+    input->iov_base = len > 0 ? malloc((size_t)len) : NULL;
+    if (len > 0 && (!input->iov_base || fread(input->iov_base, 1, (size_t)len, inputFile) != (size_t)len))
+    {
+        fprintf(stderr, "%s: Unable to read file: %s\n", __func__, inputFilePath);
+        free(input->iov_base);
+        fclose(inputFile);
+        return false;
+    }
+    fclose(inputFile);
+    return true;
+}
+
+/**
+ * @brief Appends an encoded member to the archive and fills in its directory entry
+ */
+static bool appendMember(ArchiveJob *job, size_t memberIdx, const struct iovec *input, const struct iovec *output)
+{
+    // Point the directory at the dictionary of the first block when that block is Huffman encoded
+    const uint8_t *member = (const uint8_t *)output->iov_base;
+    uint64_t dictRelOffset = 0;
+    uint64_t dictLen = 0;
+    BlockHdr firstBlock;
+    if (output->iov_len >= sizeof(BlockFileHdr) + sizeof(BlockHdr) + sizeof(dictLen))
+    {
+        memcpy(&firstBlock, member + sizeof(BlockFileHdr), sizeof(firstBlock));
+        if (firstBlock.type == BLOCK_TYPE_HUFFMAN)
+        {
+            dictRelOffset = sizeof(BlockFileHdr) + sizeof(BlockHdr) + sizeof(dictLen);
+            memcpy(&dictLen, member + sizeof(BlockFileHdr) + sizeof(BlockHdr), sizeof(dictLen));
+        }
+    }
+
+    pthread_mutex_lock(&job->writeLock);
+    ArchiveDirEntry *entry = &job->entries[memberIdx];
+    entry->offset = job->writeOffset;
+    entry->compressedLen = output->iov_len;
+    entry->originalLen = input->iov_len;
+    entry->dictOffset = dictLen ? job->writeOffset + dictRelOffset : 0;
+    entry->dictLen = dictLen;
+    bool success = fwrite(output->iov_base, 1, output->iov_len, job->archiveFile) == output->iov_len;
+    job->writeOffset += output->iov_len;
+    pthread_mutex_unlock(&job->writeLock);
+
+    if (!success)
+        fprintf(stderr, "%s: Unable to write member %s\n", __func__, job->inputPaths[memberIdx]);
+    return success;
+}
+
+/**
+ * @brief Worker loop. Every worker takes the next member that nobody has claimed yet, so a worker that got a
+ *        few small files keeps pulling members while another one is busy with a large one.
+ */
+static void *archiveWorker(void *arg)
+{
+    ArchiveJob *job = (ArchiveJob *)arg;
+    BlockEncoder enc;
+    if (!blockEncoder_init(&enc, job->options))
+        atomic_store(&job->failed, true);
+
+    while (!atomic_load(&job->failed))
+    {
+        const size_t memberIdx = atomic_fetch_add(&job->nextMember, 1);
+        if (memberIdx >= job->count)
+            break;
+
+        struct iovec input;
+        struct iovec output;
+        if (!readMemberFile(job->inputPaths[memberIdx], &input))
+        {
+            atomic_store(&job->failed, true);
+            break;
+        }
+
+        bool success = blockEncoder_encodeBuffer(&enc, (const uint8_t *)input.iov_base, input.iov_len, &output);
+        if (success)
+        {
+            success = appendMember(job, memberIdx, &input, &output);
+            free(output.iov_base);
+        }
+        else
+        {
+            fprintf(stderr, "%s: Unable to encode %s\n", __func__, job->inputPaths[memberIdx]);
+        }
+        free(input.iov_base);
+
+        if (!success)
+            atomic_store(&job->failed, true);
+    }
+
+    blockEncoder_free(&enc);
+    return NULL;
+}
+
+static bool writeDirEntry(FILE *archiveFile, const ArchiveDirEntry *entry, const char *name)
+{
+    const uint32_t nameLen = (uint32_t)strlen(name);
+    return fwrite(&entry->offset, sizeof(entry->offset), 1, archiveFile) == 1 &&
+           fwrite(&entry->compressedLen, sizeof(entry->compressedLen), 1, archiveFile) == 1 &&
+           fwrite(&entry->originalLen, sizeof(entry->originalLen), 1, archiveFile) == 1 &&
+           fwrite(&entry->dictOffset, sizeof(entry->dictOffset), 1, archiveFile) == 1 &&
+           fwrite(&entry->dictLen, sizeof(entry->dictLen), 1, archiveFile) == 1 &&
+           fwrite(&nameLen, sizeof(nameLen), 1, archiveFile) == 1 &&
+           fwrite(name, 1, nameLen, archiveFile) == nameLen;
+}
+
+static bool writeDirectory(ArchiveJob *job)
+{
+    const uint64_t dirOffset = job->writeOffset;
+    for (size_t i = 0; i < job->count; i++)
+    {
+        if (!writeDirEntry(job->archiveFile, &job->entries[i], job->inputPaths[i]))
+        {
+            fprintf(stderr, "%s: Unable to write the directory entry of %s (errno: %d)\n", __func__,
+                    job->inputPaths[i], errno);
+            return false;
+        }
+    }
+
+    const uint64_t hdr[3] = {ARCHIVE_MAGIC, job->count, dirOffset};
+    if (fseek(job->archiveFile, 0, SEEK_SET) != 0 || fwrite(hdr, sizeof(hdr), 1, job->archiveFile) != 1)
+    {
+        fprintf(stderr, "%s: Unable to write archive header\n", __func__);
+        return false;
+    }
+    return !ferror(job->archiveFile);
+}
+
+/**
+ * @brief Encode every input file into a single archive
+ *
+ * Members are encoded concurrently and written in the order they finish. The central directory at the end of
+ * the archive records where each of them ended up.
+ *
+ * @param[in] archivePath - The archive to create
+ * @param[in] inputPaths - Files to add, the paths are stored as the member names
+ * @param[in] count - Number of input files
+ * @param[in] numThreads - Number of worker threads
+ * @param[in] options - Encoder options used for every member
+ */
+bool archive_write(const char *archivePath, char *const *inputPaths, size_t count, size_t numThreads,
+                   const BlockEncoderOptions *options)
+{
+    if (!archivePath || !inputPaths)
+        return false;
+    if (numThreads == 0)
+        numThreads = 1;
+    if (numThreads > count)
+        numThreads = count;
+
+    ArchiveJob job = {
+        .inputPaths = inputPaths, .count = count, .options = options, .writeOffset = ARCHIVE_HDR_LEN};
+    atomic_init(&job.nextMember, 0);
+    atomic_init(&job.failed, false);
+    job.entries = (ArchiveDirEntry *)calloc(count ? count : 1, sizeof(ArchiveDirEntry));
+    pthread_t *threads = (pthread_t *)calloc(numThreads ? numThreads : 1, sizeof(pthread_t));
+    job.archiveFile = fopen(archivePath, "wb");
+    if (!job.entries || !threads || !job.archiveFile)
+    {
+        fprintf(stderr, "%s: Unable to create archive: %s\n", __func__, archivePath);
+        if (job.archiveFile)
+            fclose(job.archiveFile);
+        free(threads);
+        free(job.entries);
+        return false;
+    }
+    pthread_mutex_init(&job.writeLock, NULL);
+    struct stat st;
+    const bool isRegularFile = fstat(fileno(job.archiveFile), &st) == 0 && S_ISREG(st.st_mode);
+
+    // Placeholder until the directory offset is known
+    const uint8_t emptyHdr[ARCHIVE_HDR_LEN] = {0};
+    // Workers stop before taking a member once the job failed
+    if (fwrite(emptyHdr, 1, sizeof(emptyHdr), job.archiveFile) != sizeof(emptyHdr))
+        atomic_store(&job.failed, true);
+
+    size_t threadsStarted = 0;
+    for (; threadsStarted < numThreads; threadsStarted++)
+    {
+        if (pthread_create(&threads[threadsStarted], NULL, archiveWorker, &job) != 0)
+            break;
+    }
+    if (threadsStarted == 0)
+        archiveWorker(&job);
+    for (size_t i = 0; i < threadsStarted; i++)
+        pthread_join(threads[i], NULL);
+
+    bool success = !atomic_load(&job.failed) && writeDirectory(&job);
+    // The last buffered writes only go out here, e.g. ENOSPC shows up at this point
+    if (fclose(job.archiveFile) != 0)
+    {
+        fprintf(stderr, "%s: Unable to write archive: %s (errno: %d)\n", __func__, archivePath, errno);
+        success = false;
+    }
+    // A partial archive has no directory and maybe no header, don't leave it behind
+    if (success)
+        printf("Archived %zu members (%lu bytes) with %zu threads\n", count, job.writeOffset, threadsStarted);
+    else if (isRegularFile)
+        remove(archivePath);
+
+    pthread_mutex_destroy(&job.writeLock);
+    free(threads);
+    free(job.entries);
+    return success;
+}
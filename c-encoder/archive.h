@@ -0,0 +1,35 @@
+//
+// Multi-file archives made of independently encoded members.
+//
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "block_format.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// "HUFARC01" read as a little endian uint64_t, far larger than any uncompressed file length
+#define ARCHIVE_MAGIC UINT64_C(0x3130435241465548)
+
+/**
+ * @brief A central directory entry. On disk every entry is followed by a uint32_t name length and the name.
+ *
+ * Every member is a block format stream. `dictOffset`/`dictLen` point at the dictionary of its first block so that
+ * a reader can get to it without parsing the member first, both are 0 when the first block is stored.
+ */
+typedef struct
+{
+    uint64_t offset;
+    uint64_t compressedLen;
+    uint64_t originalLen;
+    uint64_t dictOffset;
+    uint64_t dictLen;
+} ArchiveDirEntry;
+
+bool archive_write(const char *archivePath, char *const *inputPaths, size_t count, size_t numThreads,
+                   const BlockEncoderOptions *options);
+
+#endif // ARCHIVE_H
@@ -0,0 +1,133 @@
+#include "block_format.h"
+#include "huffman_batch.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MESSAGE_LEN 512
+
+static uint8_t *readWholeFile(const char *inputFilePath, size_t *fileLen)
+{
+    FILE *inputFile = fopen(inputFilePath, "rb");
+    if (!inputFile)
+    {
+        fprintf(stderr, "%s: Unable to open file: %s (errno: %d)\n", __func__, inputFilePath, errno);
+        return NULL;
+    }
+    fseek(inputFile, 0, SEEK_END);
+    long len = ftell(inputFile);
+    fseek(inputFile, 0, SEEK_SET);
+
+    uint8_t *data = len > 0 ? (uint8_t *)malloc((size_t)len) : NULL;
+    if (!data || fread(data, 1, (size_t)len, inputFile) != (size_t)len)
+    {
+        fprintf(stderr, "%s: Unable to read file: %s\n", __func__, inputFilePath);
+        free(data);
+        fclose(inputFile);
+        return NULL;
+    }
+    fclose(inputFile);
+    *fileLen = (size_t)len;
+    return data;
+}
+
+static bool runBatch(HuffBatch *batch, const struct iovec *messages, size_t count, bool shareDict)
+{
+    struct iovec *outputs = (struct iovec *)calloc(count, sizeof(struct iovec));
+    HuffBatchItemStats *itemStats = (HuffBatchItemStats *)calloc(count, sizeof(HuffBatchItemStats));
+    HuffBatchStats stats;
+    bool success = outputs && itemStats &&
+                   huffBatch_compress(batch, messages, count, shareDict, outputs, itemStats, &stats);
+    if (success)
+    {
+        printf("== %s ==\n", shareDict ? "Shared dictionary" : "Dictionary per item");
+        huffBatch_printStats(stdout, &stats, itemStats, count);
+        if (shareDict)
+            printf("Shared Dict   : %lu bytes\n", batch->encodeCtx.dictSize);
+        huffBatch_freeOutputs(outputs, count);
+    }
+    free(itemStats);
+    free(outputs);
+    return success;
+}
+
+/**
+ * @brief Encodes the whole file in the block format with one entropy coder backend
+ */
+static bool runBackend(const uint8_t *data, size_t len, BlockBackend backend, bool sampleDict, const char *name)
+{
+    BlockEncoderOptions options = {.fileFlags = 0,
+                                   .backend = backend,
+                                   .useContexts = false,
+                                   .useDigrams = false,
+                                   .sampleDict = sampleDict,
+                                   .reuseDict = false};
+    BlockEncoder enc;
+    struct iovec output = {.iov_base = NULL, .iov_len = 0};
+    bool success = blockEncoder_init(&enc, &options);
+    const uint64_t startNs = huffBatch_nowNs();
+    success = success && blockEncoder_encodeBuffer(&enc, data, len, &output);
+    const uint64_t elapsedNs = huffBatch_nowNs() - startNs;
+    if (success)
+    {
+        printf("== Backend %s ==\n", name);
+        blockEncoder_printStats(stdout, &enc.stats);
+        printf("Ratio         : %.2f%%\n", len ? 100.0 * (double)output.iov_len / (double)len : 0.0);
+        printf("Throughput    : %.2f MB/s\n", elapsedNs ? (double)len * 1000.0 / (double)elapsedNs : 0.0);
+    }
+    free(output.iov_base);
+    blockEncoder_free(&enc);
+    return success;
+}
+
+/**
+ * @brief Splits a file into messages and compresses them as one batch, once with a dictionary per message and
+ *        once with a shared dictionary. Then compares the entropy coder backends of the block format, and a
+ *        sampled dictionary, on the whole file.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <file> [messageLen]\n", argv[0]);
+        return 1;
+    }
+    size_t messageLen = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_MESSAGE_LEN;
+    if (messageLen == 0)
+    {
+        fprintf(stderr, "messageLen must be greater than 0\n");
+        return 1;
+    }
+
+    size_t fileLen = 0;
+    uint8_t *fileData = readWholeFile(argv[1], &fileLen);
+    if (!fileData)
+        return 1;
+
+    const size_t count = (fileLen + messageLen - 1) / messageLen;
+    struct iovec *messages = (struct iovec *)malloc(count * sizeof(struct iovec));
+    if (!messages)
+    {
+        free(fileData);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        messages[i].iov_base = fileData + i * messageLen;
+        messages[i].iov_len = i == count - 1 ? fileLen - i * messageLen : messageLen;
+    }
+
+    HuffBatch batch;
+    huffBatch_init(&batch);
+    bool success = runBatch(&batch, messages, count, false) && runBatch(&batch, messages, count, true);
+    huffBatch_free(&batch);
+    success = success && runBackend(fileData, fileLen, BLOCK_BACKEND_HUFFMAN, false, "huffman") &&
+              runBackend(fileData, fileLen, BLOCK_BACKEND_HUFFMAN, true, "huffman, sampled dictionary") &&
+              runBackend(fileData, fileLen, BLOCK_BACKEND_TANS, false, "tans") &&
+              runBackend(fileData, fileLen, BLOCK_BACKEND_AUTO, false, "auto");
+    free(messages);
+    free(fileData);
+    return success ? 0 : 1;
+}
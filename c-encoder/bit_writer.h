@@ -0,0 +1,65 @@
+//
+// MSB first bit writer shared by the entropy coders.
+//
+
+#ifndef BIT_WRITER_H
+#define BIT_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BITS_PER_BYTE 8
+
+typedef struct
+{
+    uint64_t acc;
+    int32_t accBits;
+    uint8_t *out;
+    size_t outIdx;
+} BitWriter;
+
+static inline void bitWriter_init(BitWriter *bitWriter, uint8_t *out)
+{
+    bitWriter->acc = 0;
+    bitWriter->accBits = 0;
+    bitWriter->out = out;
+    bitWriter->outIdx = 0;
+}
+
+/**
+ * @brief Write the low `len` bits of `bits`, highest bit first
+ */
+static inline void bitWriter_putBits(BitWriter *bitWriter, uint64_t bits, int32_t len)
+{
+    // Never put more than 32 bits in at once so the accumulator can't overflow
+    int32_t remaining = len;
+    while (remaining > 0)
+    {
+        int32_t take = remaining > 32 ? 32 : remaining;
+        remaining -= take;
+        bitWriter->acc = (bitWriter->acc << take) | ((bits >> remaining) & ((UINT64_C(1) << take) - 1));
+        bitWriter->accBits += take;
+        while (bitWriter->accBits >= BITS_PER_BYTE)
+        {
+            bitWriter->accBits -= BITS_PER_BYTE;
+            bitWriter->out[bitWriter->outIdx++] = (uint8_t)(bitWriter->acc >> bitWriter->accBits);
+        }
+    }
+}
+
+/**
+ * @brief Pad the last byte with zeroes
+ *
+ * @returns The number of bytes written
+ */
+static inline size_t bitWriter_flush(BitWriter *bitWriter)
+{
+    if (bitWriter->accBits > 0)
+    {
+        bitWriter->out[bitWriter->outIdx++] = (uint8_t)(bitWriter->acc << (BITS_PER_BYTE - bitWriter->accBits));
+        bitWriter->accBits = 0;
+    }
+    return bitWriter->outIdx;
+}
+
+#endif // BIT_WRITER_H
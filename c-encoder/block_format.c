@@ -0,0 +1,834 @@
+#include "block_format.h"
+#include "crc32c.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_FILE_HDR_LEN sizeof(BlockFileHdr)
+#define BLOCK_HDR_LEN sizeof(BlockHdr)
+#define DICT_LEN_FIELD_LEN sizeof(uint64_t)
+// The sampled dictionary is built from this many bytes taken in chunks spread evenly over the input
+#define SAMPLE_LEN (64 * 1024)
+#define SAMPLE_CHUNK_LEN 1024
+
+static bool reserveScratch(BlockEncoder *enc, size_t len)
+{
+    if (enc->scratchLen >= len)
+        return true;
+
+    uint8_t *scratch = (uint8_t *)realloc(enc->scratch, len);
+    if (!scratch)
+    {
+        fprintf(stderr, "%s: Unable to grow scratch buffer to %zu bytes\n", __func__, len);
+        return false;
+    }
+    enc->scratch = scratch;
+    enc->scratchLen = len;
+    return true;
+}
+
+static size_t countSymbols(const ASCIICharMap *charMap)
+{
+    size_t numSymbols = 0;
+    for (size_t i = 0; i < ASCII_CHAR_MAP_LEN; i++)
+        numSymbols += charMap->map[i] != 0;
+    return numSymbols;
+}
+
+/**
+ * @brief A sampled dictionary is a single Huffman dictionary for every block, it doesn't go with the other backends
+ */
+bool blockEncoder_validOptions(const BlockEncoderOptions *options)
+{
+    return !options->sampleDict ||
+           (options->backend == BLOCK_BACKEND_HUFFMAN && !options->useContexts && !options->useDigrams);
+}
+
+bool blockEncoder_init(BlockEncoder *enc, const BlockEncoderOptions *options)
+{
+    huffCtx_init(&enc->encodeCtx);
+    enc->contextCtxs = NULL;
+    enc->digramCtx = NULL;
+    enc->reuseCtx = NULL;
+    enc->tans = NULL;
+    enc->tansPayload = NULL;
+    enc->scratch = NULL;
+    enc->scratchLen = 0;
+    enc->fileFlags = options->fileFlags;
+    enc->backend = options->backend;
+    enc->useContexts = options->useContexts && options->backend != BLOCK_BACKEND_TANS;
+    enc->useDigrams = options->useDigrams && options->backend != BLOCK_BACKEND_TANS;
+    enc->sampleDict = options->sampleDict;
+    enc->sampledDictSent = false;
+    enc->appending = false;
+    enc->baseOffset = 0;
+    enc->dictBlockOffset = BLOCK_END_NO_DICT;
+    enc->checksum = 0;
+    memset(&enc->stats, 0, sizeof(enc->stats));
+
+    if (!blockEncoder_validOptions(options))
+    {
+        fprintf(stderr, "%s: A sampled dictionary only goes with the Huffman backend, without contexts or digrams\n",
+                __func__);
+        return false;
+    }
+
+    // A sampled dictionary is already reused by every block
+    if (options->reuseDict && !enc->sampleDict && enc->backend != BLOCK_BACKEND_TANS)
+    {
+        enc->reuseCtx = (HuffEncodeContext *)malloc(sizeof(HuffEncodeContext));
+        if (!enc->reuseCtx)
+        {
+            fprintf(stderr, "%s: Unable to allocate reused dictionary\n", __func__);
+            return false;
+        }
+        huffCtx_init(enc->reuseCtx);
+    }
+
+    if (enc->useDigrams)
+    {
+        enc->digramCtx = (DigramEncodeContext *)malloc(sizeof(DigramEncodeContext));
+        if (!enc->digramCtx)
+        {
+            fprintf(stderr, "%s: Unable to allocate digram dictionary\n", __func__);
+            return false;
+        }
+        digramCtx_init(enc->digramCtx);
+    }
+    if (enc->backend != BLOCK_BACKEND_HUFFMAN)
+    {
+        enc->tans = (TansEncoder *)malloc(sizeof(TansEncoder));
+        if (enc->tans)
+            tans_init(enc->tans);
+        enc->tansPayload = (uint8_t *)malloc(TANS_MAX_PAYLOAD_LEN(BLOCK_LEN));
+        if (!enc->tans || !enc->tansPayload)
+        {
+            fprintf(stderr, "%s: Unable to allocate tANS encoder\n", __func__);
+            return false;
+        }
+    }
+
+    if (enc->useContexts)
+    {
+        enc->contextCtxs = (HuffEncodeContext *)malloc(HUFF_CONTEXT_CLASSES * sizeof(HuffEncodeContext));
+        if (!enc->contextCtxs)
+        {
+            fprintf(stderr, "%s: Unable to allocate context dictionaries\n", __func__);
+            return false;
+        }
+        for (size_t i = 0; i < HUFF_CONTEXT_CLASSES; i++)
+            huffCtx_init(&enc->contextCtxs[i]);
+        for (size_t c = 0; c < ASCII_CHAR_MAP_LEN; c++)
+            enc->contextClasses[c] = huffCtx_contextClass((uint8_t)c);
+    }
+    return true;
+}
+
+void blockEncoder_free(BlockEncoder *enc)
+{
+    if (enc->tans)
+        tans_free(enc->tans);
+    free(enc->tans);
+    free(enc->tansPayload);
+    free(enc->contextCtxs);
+    free(enc->digramCtx);
+    free(enc->reuseCtx);
+    free(enc->scratch);
+    enc->digramCtx = NULL;
+    enc->reuseCtx = NULL;
+    enc->tans = NULL;
+    enc->tansPayload = NULL;
+    enc->contextCtxs = NULL;
+    enc->scratch = NULL;
+    enc->scratchLen = 0;
+}
+
+size_t blockEncoder_writeFileHdr(BlockEncoder *enc, uint8_t *out)
+{
+    BlockFileHdr hdr = {.magic = BLOCK_FILE_MAGIC, .flags = enc->fileFlags, .blockLen = BLOCK_LEN};
+    memcpy(out, &hdr, sizeof(hdr));
+    // Checksums start over with every file
+    enc->checksum = 0;
+    enc->stats.bytesOut += sizeof(hdr);
+    return sizeof(hdr);
+}
+
+/**
+ * @brief Build the dictionary every block of `data` is encoded with from a sample of it instead of counting every
+ *        block, so encoding is a single pass over the data
+ *
+ * Inputs longer than `SAMPLE_LEN` are sampled in `SAMPLE_CHUNK_LEN` chunks spread evenly over them. Every byte
+ * value gets a count on top of the sample so bytes the sample missed still have a (long) code.
+ */
+bool blockEncoder_sampleDict(BlockEncoder *enc, const uint8_t *data, size_t len)
+{
+    if (!enc || (!data && len != 0))
+        return false;
+
+    HuffEncodeContext *ctx = &enc->encodeCtx;
+    huffCtx_reset(ctx);
+    if (len <= SAMPLE_LEN)
+    {
+        huffCtx_countFrequencies(ctx, data, len);
+    }
+    else
+    {
+        const size_t numChunks = SAMPLE_LEN / SAMPLE_CHUNK_LEN;
+        const size_t stride = len / numChunks;
+        for (size_t i = 0; i < numChunks; i++)
+            huffCtx_countFrequencies(ctx, data + i * stride, SAMPLE_CHUNK_LEN);
+    }
+    for (size_t c = 0; c < ASCII_CHAR_MAP_LEN; c++)
+        ctx->charMap.map[c]++;
+
+    enc->sampledDictSent = false;
+    return huffCtx_buildDict(ctx);
+}
+
+/**
+ * @brief Load the dictionary of the BLOCK_TYPE_HUFFMAN block whose header starts at `blockOffset`
+ */
+static bool loadReuseDict(BlockEncoder *enc, FILE *encodedFile, off_t blockOffset, off_t fileLen)
+{
+    BlockHdr hdr;
+    if (fseeko(encodedFile, blockOffset, SEEK_SET) != 0 ||
+        fread(&hdr, 1, BLOCK_HDR_LEN, encodedFile) != BLOCK_HDR_LEN || hdr.type != BLOCK_TYPE_HUFFMAN ||
+        (off_t)hdr.payloadLen > fileLen - blockOffset - (off_t)BLOCK_HDR_LEN)
+    {
+        fprintf(stderr, "%s: No Huffman block at offset %ld\n", __func__, (long)blockOffset);
+        return false;
+    }
+
+    uint8_t dict[sizeof(enc->reuseCtx->dict)];
+    uint64_t dictLen = 0;
+    if (hdr.payloadLen < DICT_LEN_FIELD_LEN ||
+        fread(&dictLen, 1, DICT_LEN_FIELD_LEN, encodedFile) != DICT_LEN_FIELD_LEN)
+    {
+        fprintf(stderr, "%s: Unable to read dictionary length\n", __func__);
+        return false;
+    }
+    if (dictLen > sizeof(dict) || dictLen > hdr.payloadLen - DICT_LEN_FIELD_LEN ||
+        fread(dict, 1, dictLen, encodedFile) != dictLen)
+    {
+        fprintf(stderr, "%s: Unable to read dictionary of %lu bytes\n", __func__, dictLen);
+        return false;
+    }
+    return huffCtx_loadDict(enc->reuseCtx, dict, dictLen);
+}
+
+/**
+ * @brief Get the offset of the last dictionary from the BlockEndRecord the file ends with
+ *
+ * @returns false when the file doesn't end with one
+ */
+static bool readEndRecord(FILE *encodedFile, off_t fileLen, uint64_t *dictBlockOffset, uint32_t *checksum)
+{
+    const off_t recordLen = (off_t)(BLOCK_HDR_LEN + sizeof(BlockEndRecord));
+    if (fileLen < (off_t)BLOCK_FILE_HDR_LEN + recordLen)
+        return false;
+
+    BlockHdr hdr;
+    BlockEndRecord record;
+    if (fseeko(encodedFile, fileLen - recordLen, SEEK_SET) != 0 ||
+        fread(&hdr, 1, BLOCK_HDR_LEN, encodedFile) != BLOCK_HDR_LEN ||
+        fread(&record, 1, sizeof(record), encodedFile) != sizeof(record))
+        return false;
+    if (hdr.type != BLOCK_TYPE_END || hdr.rawLen != 0 || hdr.payloadLen != sizeof(record) ||
+        record.magic != BLOCK_END_MAGIC)
+        return false;
+    if (record.dictBlockOffset != BLOCK_END_NO_DICT &&
+        (record.dictBlockOffset < BLOCK_FILE_HDR_LEN || record.dictBlockOffset >= (uint64_t)(fileLen - recordLen)))
+        return false;
+
+    *dictBlockOffset = record.dictBlockOffset;
+    *checksum = hdr.checksum;
+    return true;
+}
+
+/**
+ * @brief Add blocks to the end of a block format file instead of writing a new one
+ *
+ * Nothing already in the file changes. Only the BlockEndRecord the file ends with and the block of its last
+ * dictionary are read, so the cost doesn't grow with the file. A file without one is truncated and isn't appended
+ * to, the new blocks would hide that from the decoder. The flags of the file replace the ones of the options
+ * so every block has a checksum or none does. With `reuseDict` the dictionary of the last BLOCK_TYPE_HUFFMAN block
+ * is loaded, new blocks are encoded with it when that's smaller than any block with its own dictionary. An empty
+ * file gets a file header like a new one.
+ *
+ * The file is left at its end. `blockEncoder_encodeFile` and `blockEncoder_encodeBufferToFile` then only write
+ * blocks and a new BlockEndRecord. The caller has to keep other writers out until then.
+ *
+ * @returns false for files that aren't in the block format, have another block length or don't end with a
+ *          BlockEndRecord
+ */
+bool blockEncoder_openAppend(BlockEncoder *enc, FILE *encodedFile)
+{
+    if (!enc || !encodedFile)
+        return false;
+    if (fseeko(encodedFile, 0, SEEK_END) != 0)
+    {
+        fprintf(stderr, "%s: Unable to seek encoded file\n", __func__);
+        return false;
+    }
+    const off_t fileLen = ftello(encodedFile);
+    if (fileLen == 0)
+        return true;
+
+    BlockFileHdr fileHdr;
+    rewind(encodedFile);
+    if (fread(&fileHdr, 1, BLOCK_FILE_HDR_LEN, encodedFile) != BLOCK_FILE_HDR_LEN ||
+        fileHdr.magic != BLOCK_FILE_MAGIC)
+    {
+        fprintf(stderr, "%s: Only files in the block format can be appended to\n", __func__);
+        return false;
+    }
+    if (fileHdr.blockLen != BLOCK_LEN || (fileHdr.flags & ~BLOCK_FILE_FLAG_CRC32C))
+    {
+        fprintf(stderr, "%s: Unsupported block length %u or flags %u\n", __func__, fileHdr.blockLen, fileHdr.flags);
+        return false;
+    }
+
+    uint64_t dictBlockOffset = BLOCK_END_NO_DICT;
+    uint32_t checksum = 0;
+    if (!readEndRecord(encodedFile, fileLen, &dictBlockOffset, &checksum))
+    {
+        fprintf(stderr, "%s: File doesn't end with an end block, it is truncated\n", __func__);
+        return false;
+    }
+    if (enc->reuseCtx && dictBlockOffset != BLOCK_END_NO_DICT &&
+        !loadReuseDict(enc, encodedFile, (off_t)dictBlockOffset, fileLen))
+        return false;
+    if (fseeko(encodedFile, 0, SEEK_END) != 0)
+        return false;
+    enc->fileFlags = fileHdr.flags;
+    enc->appending = true;
+    enc->baseOffset = (uint64_t)fileLen;
+    enc->dictBlockOffset = dictBlockOffset;
+    enc->checksum = checksum;
+    return true;
+}
+
+/**
+ * @brief Work out the payload length of an order-0 Huffman block from the frequencies in `encodeCtx`
+ *
+ * @returns UINT64_MAX when the dictionary alone is as large as the block, no tree is built in that case
+ */
+static uint64_t evaluateHuffman(BlockEncoder *enc, size_t len, bool *success)
+{
+    HuffEncodeContext *ctx = &enc->encodeCtx;
+    const size_t minDictLen = countSymbols(&ctx->charMap) * sizeof(HuffmanEncoding);
+    if (len == 0 || DICT_LEN_FIELD_LEN + minDictLen >= len)
+        return UINT64_MAX;
+
+    *success = huffCtx_buildDict(ctx);
+    return DICT_LEN_FIELD_LEN + ctx->dictSize + (huffCtx_encodedBits(ctx) + 7) / 8;
+}
+
+/**
+ * @brief Work out the payload length of a block with one dictionary per context class
+ */
+static uint64_t evaluateContexts(BlockEncoder *enc, const uint8_t *data, size_t len, bool *success)
+{
+    HuffEncodeContext *ctxs = enc->contextCtxs;
+    for (size_t i = 0; i < HUFF_CONTEXT_CLASSES; i++)
+        huffCtx_reset(&ctxs[i]);
+    huffCtx_countFrequenciesOrder1(ctxs, enc->contextClasses, data, len);
+
+    size_t minDictLen = 0;
+    for (size_t i = 0; i < HUFF_CONTEXT_CLASSES; i++)
+        minDictLen += DICT_LEN_FIELD_LEN + countSymbols(&ctxs[i].charMap) * sizeof(HuffmanEncoding);
+    if (len == 0 || minDictLen >= len)
+        return UINT64_MAX;
+
+    uint64_t payloadLen = 0;
+    uint64_t encodedBits = 0;
+    for (size_t i = 0; i < HUFF_CONTEXT_CLASSES; i++)
+    {
+        if (countSymbols(&ctxs[i].charMap) != 0 && !huffCtx_buildDict(&ctxs[i]))
+            *success = false;
+        payloadLen += DICT_LEN_FIELD_LEN + ctxs[i].dictSize;
+        encodedBits += huffCtx_encodedBits(&ctxs[i]);
+    }
+    return payloadLen + (encodedBits + 7) / 8;
+}
+
+/**
+ * @brief Work out the payload length of a block with the most frequent digrams as extra symbols
+ *
+ * @returns UINT64_MAX when no digram is frequent enough, the block would be the same as an order-0 Huffman block
+ */
+static uint64_t evaluateDigrams(BlockEncoder *enc, const uint8_t *data, size_t len, bool *success)
+{
+    const size_t minDictLen = countSymbols(&enc->encodeCtx.charMap) * sizeof(HuffmanStringEncoding);
+    if (len == 0 || DICT_LEN_FIELD_LEN + minDictLen >= len)
+        return UINT64_MAX;
+
+    DigramEncodeContext *ctx = enc->digramCtx;
+    if (!digramCtx_buildDict(ctx, data, len))
+    {
+        *success = false;
+        return UINT64_MAX;
+    }
+    if (ctx->numDigrams == 0)
+        return UINT64_MAX;
+    return DICT_LEN_FIELD_LEN + ctx->dictSize + (digramCtx_encodedBits(ctx) + 7) / 8;
+}
+
+/**
+ * @brief Encode the block with tANS into `tansPayload`, the exact length is only known once it's encoded
+ */
+static uint64_t evaluateTans(BlockEncoder *enc, const uint8_t *data, size_t len, bool *success)
+{
+    const size_t minTableLen = sizeof(TansTableHdr) + countSymbols(&enc->encodeCtx.charMap) * TANS_TABLE_ENTRY_LEN;
+    if (len == 0 || minTableLen >= len)
+        return UINT64_MAX;
+
+    size_t payloadLen = 0;
+    if (!tans_buildTable(enc->tans, &enc->encodeCtx.charMap) ||
+        !tans_encode(enc->tans, data, len, enc->tansPayload, &payloadLen))
+    {
+        *success = false;
+        return UINT64_MAX;
+    }
+    return payloadLen;
+}
+
+/**
+ * @brief Work out the payload length of the block encoded with the dictionary of the last Huffman block
+ *
+ * @returns UINT64_MAX when a character of the block has no code in that dictionary
+ */
+static uint64_t evaluateReuse(const BlockEncoder *enc)
+{
+    const HuffEncodeContext *reuseCtx = enc->reuseCtx;
+    const ASCIICharMap *charMap = &enc->encodeCtx.charMap;
+    uint64_t bits = 0;
+    for (size_t c = 0; c < ASCII_CHAR_MAP_LEN; c++)
+    {
+        if (charMap->map[c] == 0)
+            continue;
+        if (!reuseCtx->lookup[c])
+            return UINT64_MAX;
+        bits += charMap->map[c] * (uint64_t)reuseCtx->lookup[c]->length;
+    }
+    return (bits + 7) / 8;
+}
+
+/**
+ * @brief Give every character of the reused dictionary a count of at least 1 before building a new dictionary
+ *
+ * A block can only reuse a dictionary with a code for every character in it. Carrying the characters over lets the
+ * blocks after a new dictionary keep reusing it for a few more bytes of dictionary.
+ *
+ * @param[out] carried - Set for the characters that were added, to take them out again afterwards
+ */
+static void carryReuseSymbols(BlockEncoder *enc, bool *carried)
+{
+    ASCIICharMap *charMap = &enc->encodeCtx.charMap;
+    for (size_t c = 0; c < ASCII_CHAR_MAP_LEN; c++)
+    {
+        carried[c] = charMap->map[c] == 0 && enc->reuseCtx->lookup[c];
+        charMap->map[c] += carried[c];
+    }
+}
+
+/**
+ * @brief Largest payload of a block encoded with the sampled dictionary. The dictionary goes out with the first
+ *        block that isn't stored and the blocks after it reuse it.
+ */
+static uint64_t sampledPayloadBound(const BlockEncoder *enc, size_t len)
+{
+    const HuffEncodeContext *ctx = &enc->encodeCtx;
+    const uint64_t dictLen = enc->sampledDictSent ? 0 : DICT_LEN_FIELD_LEN + ctx->dictSize;
+    return dictLen + ((uint64_t)len * (uint64_t)ctx->maxLength + 7) / 8;
+}
+
+static void countBlock(BlockStats *stats, BlockType type)
+{
+    switch (type)
+    {
+    case BLOCK_TYPE_HUFFMAN:
+        stats->huffmanBlocks++;
+        break;
+    case BLOCK_TYPE_HUFFMAN_REUSE:
+        stats->reuseBlocks++;
+        break;
+    case BLOCK_TYPE_HUFFMAN_CONTEXT:
+        stats->contextBlocks++;
+        break;
+    case BLOCK_TYPE_HUFFMAN_DIGRAM:
+        stats->digramBlocks++;
+        break;
+    case BLOCK_TYPE_TANS:
+        stats->tansBlocks++;
+        break;
+    default:
+        stats->storedBlocks++;
+        break;
+    }
+}
+
+/**
+ * @brief Count the frequencies of the block once and work out the payload length of every enabled backend
+ *
+ * @returns The smallest payload length, `hdr->type` is set to the block type it belongs to
+ */
+static uint64_t chooseBlockType(BlockEncoder *enc, const uint8_t *data, size_t len, BlockHdr *hdr, bool *success)
+{
+    uint64_t bestPayloadLen = len;
+    huffCtx_reset(&enc->encodeCtx);
+    huffCtx_countFrequencies(&enc->encodeCtx, data, len);
+
+    const bool canReuse = enc->reuseCtx && enc->reuseCtx->dictBuilt;
+    if (canReuse)
+    {
+        const uint64_t reusePayloadLen = evaluateReuse(enc);
+        if (reusePayloadLen < bestPayloadLen)
+        {
+            hdr->type = BLOCK_TYPE_HUFFMAN_REUSE;
+            bestPayloadLen = reusePayloadLen;
+        }
+    }
+    if (enc->backend != BLOCK_BACKEND_TANS)
+    {
+        bool carried[ASCII_CHAR_MAP_LEN] = {false};
+        if (canReuse)
+            carryReuseSymbols(enc, carried);
+        const uint64_t huffPayloadLen = evaluateHuffman(enc, len, success);
+        if (huffPayloadLen < bestPayloadLen)
+        {
+            hdr->type = BLOCK_TYPE_HUFFMAN;
+            bestPayloadLen = huffPayloadLen;
+        }
+        if (canReuse)
+        {
+            for (size_t c = 0; c < ASCII_CHAR_MAP_LEN; c++)
+                enc->encodeCtx.charMap.map[c] -= carried[c];
+        }
+    }
+    if (enc->useContexts)
+    {
+        const uint64_t contextPayloadLen = evaluateContexts(enc, data, len, success);
+        if (contextPayloadLen < bestPayloadLen)
+        {
+            hdr->type = BLOCK_TYPE_HUFFMAN_CONTEXT;
+            bestPayloadLen = contextPayloadLen;
+        }
+    }
+    if (enc->useDigrams)
+    {
+        const uint64_t digramPayloadLen = evaluateDigrams(enc, data, len, success);
+        if (digramPayloadLen < bestPayloadLen)
+        {
+            hdr->type = BLOCK_TYPE_HUFFMAN_DIGRAM;
+            bestPayloadLen = digramPayloadLen;
+        }
+    }
+    if (enc->backend != BLOCK_BACKEND_HUFFMAN)
+    {
+        const uint64_t tansPayloadLen = evaluateTans(enc, data, len, success);
+        if (tansPayloadLen < bestPayloadLen)
+        {
+            hdr->type = BLOCK_TYPE_TANS;
+            bestPayloadLen = tansPayloadLen;
+        }
+    }
+    return bestPayloadLen;
+}
+
+static size_t writeDictWithLen(const HuffEncodeContext *ctx, uint8_t *out)
+{
+    memcpy(out, &ctx->dictSize, DICT_LEN_FIELD_LEN);
+    return DICT_LEN_FIELD_LEN + huffCtx_writeDict(ctx, out + DICT_LEN_FIELD_LEN);
+}
+
+static bool writeHuffmanPayload(BlockEncoder *enc, const uint8_t *data, size_t len, uint8_t *payload,
+                                size_t *payloadLen)
+{
+    size_t offset = writeDictWithLen(&enc->encodeCtx, payload);
+    size_t encodedLen = 0;
+    if (!huffCtx_encodeData(&enc->encodeCtx, data, len, payload + offset, &encodedLen))
+        return false;
+    *payloadLen = offset + encodedLen;
+    return true;
+}
+
+static bool writeContextPayload(BlockEncoder *enc, const uint8_t *data, size_t len, uint8_t *payload,
+                                size_t *payloadLen)
+{
+    size_t offset = 0;
+    for (size_t i = 0; i < HUFF_CONTEXT_CLASSES; i++)
+        offset += writeDictWithLen(&enc->contextCtxs[i], payload + offset);
+    size_t encodedLen = 0;
+    if (!huffCtx_encodeDataOrder1(enc->contextCtxs, enc->contextClasses, data, len, payload + offset,
+                                  &encodedLen))
+        return false;
+    *payloadLen = offset + encodedLen;
+    return true;
+}
+
+static bool writeDigramPayload(BlockEncoder *enc, const uint8_t *data, size_t len, uint8_t *payload,
+                               size_t *payloadLen)
+{
+    const DigramEncodeContext *ctx = enc->digramCtx;
+    memcpy(payload, &ctx->dictSize, DICT_LEN_FIELD_LEN);
+    size_t offset = DICT_LEN_FIELD_LEN + digramCtx_writeDict(ctx, payload + DICT_LEN_FIELD_LEN);
+    size_t encodedLen = 0;
+    if (!digramCtx_encodeData(ctx, data, len, payload + offset, &encodedLen))
+        return false;
+    *payloadLen = offset + encodedLen;
+    return true;
+}
+
+/**
+ * @brief Encode a single block of at most `BLOCK_LEN` bytes
+ *
+ * With a sampled dictionary the block is encoded with it straight away and only stored when that turns out no
+ * smaller. Otherwise the frequencies are counted once and shared by every backend. The size of the Huffman encoded
+ * block is worked out from them and the code lengths before anything is encoded, with order-1 contexts and digrams
+ * as well when they are enabled. The tANS backend encodes the block to find its size. The smallest of those and the
+ * original data is written, so a block that doesn't compress is stored. With `BLOCK_FILE_FLAG_CRC32C` the checksum
+ * continues from the one of the previous block and is taken while the block is still in cache from counting the
+ * frequencies.
+ *
+ * @param[in] data - The data of the block
+ * @param[in] len - Length of data
+ * @param[out] out - The block is `out[0]` followed by `out[1]`. `out[0]` points into the scratch buffer of the
+ *                   encoder and `out[1]` into `data` or the tANS payload of the encoder, both are only valid until
+ *                   the next call
+ */
+bool blockEncoder_encodeBlock(BlockEncoder *enc, const uint8_t *data, size_t len, struct iovec out[2])
+{
+    if (!enc || !out || len > BLOCK_LEN)
+        return false;
+    if (enc->sampleDict && !enc->encodeCtx.dictBuilt)
+    {
+        fprintf(stderr, "%s: No sampled dictionary, call blockEncoder_sampleDict first\n", __func__);
+        return false;
+    }
+
+    bool success = true;
+    BlockHdr hdr = {.type = BLOCK_TYPE_STORED, .rawLen = (uint32_t)len, .payloadLen = (uint32_t)len};
+    uint64_t bestPayloadLen = len;
+
+    if (enc->sampleDict)
+    {
+        hdr.type = enc->sampledDictSent ? BLOCK_TYPE_HUFFMAN_REUSE : BLOCK_TYPE_HUFFMAN;
+        bestPayloadLen = sampledPayloadBound(enc, len);
+    }
+    else
+    {
+        bestPayloadLen = chooseBlockType(enc, data, len, &hdr, &success);
+    }
+    if (!success || !reserveScratch(enc, BLOCK_HDR_LEN + bestPayloadLen))
+        return false;
+
+    if (enc->fileFlags & BLOCK_FILE_FLAG_CRC32C)
+        hdr.checksum = crc32c(enc->checksum, data, len);
+
+    uint8_t *payload = enc->scratch + BLOCK_HDR_LEN;
+    size_t payloadLen = 0;
+    switch (hdr.type)
+    {
+    case BLOCK_TYPE_HUFFMAN:
+        success = writeHuffmanPayload(enc, data, len, payload, &payloadLen);
+        break;
+    case BLOCK_TYPE_HUFFMAN_REUSE:
+        success = huffCtx_encodeData(enc->sampleDict ? &enc->encodeCtx : enc->reuseCtx, data, len, payload,
+                                     &payloadLen);
+        break;
+    case BLOCK_TYPE_HUFFMAN_CONTEXT:
+        success = writeContextPayload(enc, data, len, payload, &payloadLen);
+        break;
+    case BLOCK_TYPE_HUFFMAN_DIGRAM:
+        success = writeDigramPayload(enc, data, len, payload, &payloadLen);
+        break;
+    case BLOCK_TYPE_TANS:
+        payloadLen = bestPayloadLen;
+        break;
+    default:
+        break;
+    }
+    if (!success)
+        return false;
+
+    // The size of a block encoded with the sampled dictionary is only known once it's encoded
+    if (enc->sampleDict && payloadLen >= len)
+        hdr.type = BLOCK_TYPE_STORED;
+    if (enc->sampleDict && hdr.type == BLOCK_TYPE_HUFFMAN)
+        enc->sampledDictSent = true;
+    if (hdr.type == BLOCK_TYPE_HUFFMAN)
+        enc->dictBlockOffset = enc->baseOffset + enc->stats.bytesOut;
+    // The decoder reuses the dictionary of the last Huffman block, whichever block it was in
+    if (enc->reuseCtx && hdr.type == BLOCK_TYPE_HUFFMAN &&
+        !huffCtx_loadDict(enc->reuseCtx, (const uint8_t *)enc->encodeCtx.dict, enc->encodeCtx.dictSize))
+        return false;
+    countBlock(&enc->stats, (BlockType)hdr.type);
+
+    if (hdr.type == BLOCK_TYPE_STORED)
+    {
+        out[0].iov_len = BLOCK_HDR_LEN;
+        out[1].iov_base = (void *)data;
+        out[1].iov_len = len;
+    }
+    else if (hdr.type == BLOCK_TYPE_TANS)
+    {
+        hdr.payloadLen = (uint32_t)payloadLen;
+        out[0].iov_len = BLOCK_HDR_LEN;
+        out[1].iov_base = enc->tansPayload;
+        out[1].iov_len = payloadLen;
+    }
+    else
+    {
+        hdr.payloadLen = (uint32_t)payloadLen;
+        out[0].iov_len = BLOCK_HDR_LEN + payloadLen;
+        out[1].iov_base = NULL;
+        out[1].iov_len = 0;
+    }
+    memcpy(enc->scratch, &hdr, BLOCK_HDR_LEN);
+    out[0].iov_base = enc->scratch;
+
+    enc->checksum = hdr.checksum;
+    enc->stats.bytesIn += len;
+    enc->stats.bytesOut += out[0].iov_len + out[1].iov_len;
+    return true;
+}
+
+/**
+ * @brief Encode a whole buffer, file header included
+ *
+ * @param[out] output - Free with `free(output->iov_base)`
+ */
+bool blockEncoder_encodeBuffer(BlockEncoder *enc, const uint8_t *data, size_t len, struct iovec *output)
+{
+    if (!enc || !output)
+        return false;
+    if (enc->sampleDict && !blockEncoder_sampleDict(enc, data, len))
+        return false;
+
+    // A block is never larger than its header plus the original data
+    const size_t numBlocks = (len + BLOCK_LEN - 1) / BLOCK_LEN;
+    uint8_t *out = (uint8_t *)malloc(BLOCK_FILE_HDR_LEN + numBlocks * BLOCK_HDR_LEN + len);
+    if (!out)
+    {
+        fprintf(stderr, "%s: Unable to allocate output\n", __func__);
+        return false;
+    }
+
+    size_t outLen = blockEncoder_writeFileHdr(enc, out);
+    for (size_t offset = 0; offset < len; offset += BLOCK_LEN)
+    {
+        const size_t blockLen = len - offset < BLOCK_LEN ? len - offset : BLOCK_LEN;
+        struct iovec block[2];
+        if (!blockEncoder_encodeBlock(enc, data + offset, blockLen, block))
+        {
+            free(out);
+            return false;
+        }
+        for (size_t i = 0; i < 2; i++)
+        {
+            if (block[i].iov_len == 0)
+                continue;
+            memcpy(out + outLen, block[i].iov_base, block[i].iov_len);
+            outLen += block[i].iov_len;
+        }
+    }
+
+    output->iov_base = out;
+    output->iov_len = outLen;
+    return true;
+}
+
+static bool writeBlock(const struct iovec block[2], FILE *outputFile)
+{
+    for (size_t i = 0; i < 2; i++)
+    {
+        if (block[i].iov_len != 0 && fwrite(block[i].iov_base, 1, block[i].iov_len, outputFile) != block[i].iov_len)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write the BlockEndRecord that ends a file
+ */
+static bool writeEndRecord(BlockEncoder *enc, FILE *outputFile)
+{
+    const BlockHdr hdr = {.type = BLOCK_TYPE_END, .payloadLen = sizeof(BlockEndRecord), .checksum = enc->checksum};
+    const BlockEndRecord record = {.dictBlockOffset = enc->dictBlockOffset, .magic = BLOCK_END_MAGIC};
+    uint8_t out[BLOCK_HDR_LEN + sizeof(record)];
+    memcpy(out, &hdr, BLOCK_HDR_LEN);
+    memcpy(out + BLOCK_HDR_LEN, &record, sizeof(record));
+    enc->stats.bytesOut += sizeof(out);
+    return fwrite(out, 1, sizeof(out), outputFile) == sizeof(out);
+}
+
+/**
+ * @brief Encode a file one block at a time, only a single block is held in memory
+ *
+ * A sampled dictionary needs the whole input, use `blockEncoder_encodeBufferToFile` for that.
+ */
+bool blockEncoder_encodeFile(BlockEncoder *enc, FILE *inputFile, FILE *outputFile)
+{
+    if (!enc || !inputFile || !outputFile)
+        return false;
+
+    uint8_t *blockBuf = (uint8_t *)malloc(BLOCK_LEN);
+    if (!blockBuf)
+    {
+        fprintf(stderr, "%s: Unable to allocate block buffer\n", __func__);
+        return false;
+    }
+
+    uint8_t fileHdr[BLOCK_FILE_HDR_LEN];
+    bool success =
+        enc->appending || fwrite(fileHdr, 1, blockEncoder_writeFileHdr(enc, fileHdr), outputFile) == sizeof(fileHdr);
+    size_t bytesRead = 0;
+    while (success && (bytesRead = fread(blockBuf, 1, BLOCK_LEN, inputFile)) > 0)
+    {
+        struct iovec block[2];
+        success = blockEncoder_encodeBlock(enc, blockBuf, bytesRead, block);
+        success = success && writeBlock(block, outputFile);
+    }
+
+    if (ferror(inputFile) || ferror(outputFile))
+        success = false;
+    success = success && writeEndRecord(enc, outputFile);
+    free(blockBuf);
+    return success;
+}
+
+/**
+ * @brief Encode a whole buffer, usually a mapped file, straight to `outputFile`
+ */
+bool blockEncoder_encodeBufferToFile(BlockEncoder *enc, const uint8_t *data, size_t len, FILE *outputFile)
+{
+    if (!enc || !outputFile)
+        return false;
+    if (enc->sampleDict && !blockEncoder_sampleDict(enc, data, len))
+        return false;
+
+    uint8_t fileHdr[BLOCK_FILE_HDR_LEN];
+    bool success =
+        enc->appending || fwrite(fileHdr, 1, blockEncoder_writeFileHdr(enc, fileHdr), outputFile) == sizeof(fileHdr);
+    for (size_t offset = 0; success && offset < len; offset += BLOCK_LEN)
+    {
+        const size_t blockLen = len - offset < BLOCK_LEN ? len - offset : BLOCK_LEN;
+        struct iovec block[2];
+        success = blockEncoder_encodeBlock(enc, data + offset, blockLen, block);
+        success = success && writeBlock(block, outputFile);
+    }
+    return success && writeEndRecord(enc, outputFile) && !ferror(outputFile);
+}
+
+void blockEncoder_printStats(FILE *stream, const BlockStats *stats)
+{
+    fprintf(stream, "Huffman Blocks: %lu\n", stats->huffmanBlocks);
+    fprintf(stream, "Reuse Blocks  : %lu\n", stats->reuseBlocks);
+    fprintf(stream, "Context Blocks: %lu\n", stats->contextBlocks);
+    fprintf(stream, "Digram Blocks : %lu\n", stats->digramBlocks);
+    fprintf(stream, "tANS Blocks   : %lu\n", stats->tansBlocks);
+    fprintf(stream, "Stored Blocks : %lu\n", stats->storedBlocks);
+    fprintf(stream, "Bytes In      : %lu\n", stats->bytesIn);
+    fprintf(stream, "Bytes Out     : %lu\n", stats->bytesOut);
+}
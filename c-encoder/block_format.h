@@ -0,0 +1,165 @@
+//
+// Block format: the input is split into blocks that are each either entropy coded or stored as is.
+//
+
+#ifndef BLOCK_FORMAT_H
+#define BLOCK_FORMAT_H
+
+#include "digram_encoding.h"
+#include "huffman_encoding.h"
+#include "tans.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/uio.h>
+
+// "HUFBLK01" read as a little endian uint64_t, far larger than any uncompressed file length
+#define BLOCK_FILE_MAGIC UINT64_C(0x31304B4C42465548)
+#define BLOCK_LEN (64 * 1024)
+
+// Every block header carries a CRC32C of the original data of the file up to the end of the block, so a block that
+// goes missing or moves is caught as well
+#define BLOCK_FILE_FLAG_CRC32C 0x1u
+
+// "HUFBLKND" read as a little endian uint64_t
+#define BLOCK_END_MAGIC UINT64_C(0x444E4B4C42465548)
+// `BlockEndRecord::dictBlockOffset` of a file without a BLOCK_TYPE_HUFFMAN block
+#define BLOCK_END_NO_DICT UINT64_MAX
+
+typedef enum
+{
+    BLOCK_TYPE_STORED = 0,
+    BLOCK_TYPE_HUFFMAN = 1,
+    BLOCK_TYPE_HUFFMAN_CONTEXT = 2,
+    BLOCK_TYPE_TANS = 3,
+    BLOCK_TYPE_HUFFMAN_REUSE = 4,
+    BLOCK_TYPE_HUFFMAN_DIGRAM = 5,
+    BLOCK_TYPE_END = 6,
+} BlockType;
+
+/**
+ * @brief Entropy coders the encoder picks from for every block
+ */
+typedef enum
+{
+    BLOCK_BACKEND_HUFFMAN = 0,
+    BLOCK_BACKEND_TANS,
+    // Whichever of the two gives the smaller block
+    BLOCK_BACKEND_AUTO,
+} BlockBackend;
+
+typedef struct
+{
+    uint64_t magic;
+    uint32_t flags;
+    uint32_t blockLen;
+} BlockFileHdr;
+
+/**
+ * @brief Precedes every block. `payloadLen` bytes follow the header:
+ *        - BLOCK_TYPE_STORED: `rawLen` bytes of the original data
+ *        - BLOCK_TYPE_HUFFMAN: a uint64_t dictionary length, the dictionary and the encoded data
+ *        - BLOCK_TYPE_HUFFMAN_CONTEXT: a uint64_t dictionary length and a dictionary for each of the
+ *          `HUFF_CONTEXT_CLASSES` context classes, then the encoded data. Every character is encoded with the
+ *          dictionary of the class of the character before it (see `huffCtx_contextClass`).
+ *        - BLOCK_TYPE_TANS: a tANS table and the encoded data (see `TansTableHdr`)
+ *        - BLOCK_TYPE_HUFFMAN_REUSE: only the encoded data, encoded with the dictionary of the last
+ *          BLOCK_TYPE_HUFFMAN block before it
+ *        - BLOCK_TYPE_HUFFMAN_DIGRAM: a uint64_t dictionary length, a dictionary of `HuffmanStringEncoding` entries
+ *          and the encoded data. Chosen digrams are taken greedily wherever they start (see `digramCtx_buildDict`).
+ *        - BLOCK_TYPE_END: a `BlockEndRecord`, `rawLen` is 0 and `checksum` the one of the block before it
+ */
+typedef struct
+{
+    uint8_t type;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t rawLen;
+    uint32_t payloadLen;
+    uint32_t checksum;
+} BlockHdr;
+
+/**
+ * @brief Ends every file written by `blockEncoder_encodeFile` and `blockEncoder_encodeBufferToFile`, so appending
+ *        only reads the end of the file instead of every block header. The decoder skips it, a file that was
+ *        appended to has one after the blocks of every run.
+ */
+typedef struct
+{
+    // Offset of the header of the last BLOCK_TYPE_HUFFMAN block from the start of the file, or BLOCK_END_NO_DICT
+    uint64_t dictBlockOffset;
+    uint64_t magic;
+} BlockEndRecord;
+
+typedef struct
+{
+    uint64_t storedBlocks;
+    uint64_t huffmanBlocks;
+    uint64_t reuseBlocks;
+    uint64_t contextBlocks;
+    uint64_t digramBlocks;
+    uint64_t tansBlocks;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+} BlockStats;
+
+typedef struct
+{
+    uint32_t fileFlags;
+    BlockBackend backend;
+    // Also try one dictionary per context class of the previous character for every Huffman block
+    bool useContexts;
+    // Also try the most frequent digrams of every block as extra symbols
+    bool useDigrams;
+    // Encode every block with one dictionary built from a sample of the input, see blockEncoder_sampleDict. Only
+    // valid with BLOCK_BACKEND_HUFFMAN and without useContexts or useDigrams
+    bool sampleDict;
+    // Also try the dictionary of the last BLOCK_TYPE_HUFFMAN block for every block, see blockEncoder_openAppend
+    bool reuseDict;
+} BlockEncoderOptions;
+
+typedef struct
+{
+    HuffEncodeContext encodeCtx;
+    HuffEncodeContext *contextCtxs;
+    uint8_t contextClasses[ASCII_CHAR_MAP_LEN];
+    DigramEncodeContext *digramCtx;
+    // Dictionary of the last BLOCK_TYPE_HUFFMAN block when `reuseDict` is set
+    HuffEncodeContext *reuseCtx;
+    TansEncoder *tans;
+    uint8_t *tansPayload;
+    uint8_t *scratch;
+    size_t scratchLen;
+    uint32_t fileFlags;
+    BlockBackend backend;
+    bool useContexts;
+    bool useDigrams;
+    bool sampleDict;
+    bool sampledDictSent;
+    // Blocks go after the ones of an existing file, the file header is already there
+    bool appending;
+    // Length of the file before the first byte this encoder writes, 0 unless appending
+    uint64_t baseOffset;
+    // Written to the BlockEndRecord, see there
+    uint64_t dictBlockOffset;
+    // Checksum of the last block, the next one continues from it
+    uint32_t checksum;
+    BlockStats stats;
+} BlockEncoder;
+
+bool blockEncoder_validOptions(const BlockEncoderOptions *options);
+bool blockEncoder_init(BlockEncoder *enc, const BlockEncoderOptions *options);
+void blockEncoder_free(BlockEncoder *enc);
+
+size_t blockEncoder_writeFileHdr(BlockEncoder *enc, uint8_t *out);
+bool blockEncoder_sampleDict(BlockEncoder *enc, const uint8_t *data, size_t len);
+bool blockEncoder_openAppend(BlockEncoder *enc, FILE *encodedFile);
+bool blockEncoder_encodeBlock(BlockEncoder *enc, const uint8_t *data, size_t len, struct iovec out[2]);
+bool blockEncoder_encodeBuffer(BlockEncoder *enc, const uint8_t *data, size_t len, struct iovec *output);
+bool blockEncoder_encodeFile(BlockEncoder *enc, FILE *inputFile, FILE *outputFile);
+bool blockEncoder_encodeBufferToFile(BlockEncoder *enc, const uint8_t *data, size_t len, FILE *outputFile);
+
+void blockEncoder_printStats(FILE *stream, const BlockStats *stats);
+
+#endif // BLOCK_FORMAT_H
@@ -0,0 +1,82 @@
+#include "crc32c.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42 1
+#endif
+
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t crcTable[8][256];
+static uint32_t (*crc32cImpl)(uint32_t, const uint8_t *, size_t);
+static pthread_once_t crcInitOnce = PTHREAD_ONCE_INIT;
+
+static uint32_t crc32cSlicing8(uint32_t crc, const uint8_t *data, size_t len)
+{
+    while (len >= 8)
+    {
+        // Loaded little endian, the low 4 bytes line up with the crc
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        word ^= crc;
+        crc = crcTable[7][word & 0xff] ^ crcTable[6][(word >> 8) & 0xff] ^ crcTable[5][(word >> 16) & 0xff] ^
+              crcTable[4][(word >> 24) & 0xff] ^ crcTable[3][(word >> 32) & 0xff] ^
+              crcTable[2][(word >> 40) & 0xff] ^ crcTable[1][(word >> 48) & 0xff] ^ crcTable[0][word >> 56];
+        data += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = (crc >> 8) ^ crcTable[0][(crc ^ *data++) & 0xff];
+    return crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+__attribute__((target("sse4.2"))) static uint32_t crc32cSse42(uint32_t crc, const uint8_t *data, size_t len)
+{
+    uint64_t crc64 = crc;
+    while (len >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while (len--)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#endif
+
+static void crc32cInit(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+        crcTable[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (int slice = 1; slice < 8; slice++)
+            crcTable[slice][i] = (crcTable[slice - 1][i] >> 8) ^ crcTable[0][crcTable[slice - 1][i] & 0xff];
+    }
+
+    crc32cImpl = crc32cSlicing8;
+#ifdef CRC32C_HAVE_SSE42
+    if (__builtin_cpu_supports("sse4.2"))
+        crc32cImpl = crc32cSse42;
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+    pthread_once(&crcInitOnce, crc32cInit);
+    return ~crc32cImpl(~crc, (const uint8_t *)data, len);
+}
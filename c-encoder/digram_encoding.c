@@ -0,0 +1,188 @@
+#include "digram_encoding.h"
+#include "bit_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void digramCtx_init(DigramEncodeContext *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+/**
+ * @brief Take the next symbol of `data` at `*pos`, a chosen digram wins over its first byte
+ */
+static inline uint16_t nextSymbol(const DigramEncodeContext *ctx, const uint8_t *data, size_t len, size_t *pos)
+{
+    const size_t i = *pos;
+    if (i + 1 < len)
+    {
+        const uint16_t symbol = ctx->digramSymbols[(uint16_t)(data[i] << 8 | data[i + 1])];
+        if (symbol != 0)
+        {
+            *pos = i + 2;
+            return symbol;
+        }
+    }
+    *pos = i + 1;
+    return data[i];
+}
+
+/**
+ * @brief Keep the `DIGRAM_MAX_SYMBOLS` most frequent digrams that occur at least `DIGRAM_MIN_COUNT` times, in
+ *        `ctx->digrams` from most to least frequent
+ */
+static void chooseDigrams(DigramEncodeContext *ctx)
+{
+    uint32_t keptCounts[DIGRAM_MAX_SYMBOLS];
+    ctx->numDigrams = 0;
+    for (size_t i = 0; i < ctx->numSeenDigrams; i++)
+    {
+        const uint16_t digram = ctx->seenDigrams[i];
+        const uint32_t count = ctx->digramCounts[digram];
+        ctx->digramCounts[digram] = 0;
+        if (count < DIGRAM_MIN_COUNT)
+            continue;
+        if (ctx->numDigrams == DIGRAM_MAX_SYMBOLS && count <= keptCounts[DIGRAM_MAX_SYMBOLS - 1])
+            continue;
+
+        // Insertion into the short sorted list, the least frequent digram drops off the end once it's full
+        size_t pos = ctx->numDigrams < DIGRAM_MAX_SYMBOLS ? ctx->numDigrams++ : DIGRAM_MAX_SYMBOLS - 1;
+        while (pos > 0 && keptCounts[pos - 1] < count)
+        {
+            ctx->digrams[pos] = ctx->digrams[pos - 1];
+            keptCounts[pos] = keptCounts[pos - 1];
+            pos--;
+        }
+        ctx->digrams[pos] = digram;
+        keptCounts[pos] = count;
+    }
+
+    for (size_t i = 0; i < ctx->numDigrams; i++)
+        ctx->digramSymbols[ctx->digrams[i]] = (uint16_t)(ASCII_CHAR_MAP_LEN + i);
+    ctx->numSeenDigrams = 0;
+}
+
+static bool assignCodes(DigramEncodeContext *ctx, const TreeNode *node, uint64_t bitStr, int32_t length,
+                        HuffmanStringEncoding **entry)
+{
+    if (node->left || node->right)
+    {
+        return (!node->left || assignCodes(ctx, node->left, bitStr << 1, length + 1, entry)) &&
+               (!node->right || assignCodes(ctx, node->right, (bitStr << 1) | 1, length + 1, entry));
+    }
+
+    if (*entry == ctx->dict + DIGRAM_ALPHABET_LEN)
+    {
+        fprintf(stderr, "%s: Reached end of array\n", __func__);
+        return false;
+    }
+    HuffmanStringEncoding *he = (*entry)++;
+    memset(he, 0, sizeof(*he));
+    he->bitStr = bitStr;
+    // A single distinct symbol ends up as the root of the tree, give it a one bit code so it can be written
+    he->length = length == 0 ? 1 : length;
+    if (node->symbol < ASCII_CHAR_MAP_LEN)
+    {
+        he->symLen = 1;
+        he->bytes[0] = (uint8_t)node->symbol;
+    }
+    else
+    {
+        const uint16_t digram = ctx->digrams[node->symbol - ASCII_CHAR_MAP_LEN];
+        he->symLen = 2;
+        he->bytes[0] = (uint8_t)(digram >> 8);
+        he->bytes[1] = (uint8_t)digram;
+    }
+    ctx->lookup[node->symbol] = he;
+    if (he->length > ctx->maxLength)
+        ctx->maxLength = he->length;
+    return true;
+}
+
+/**
+ * @brief Pick the digrams of the block and build the dictionary of the extended alphabet
+ *
+ * The digrams are counted in one pass over the block. The data is then split into symbols greedily, a chosen
+ * digram is taken wherever it starts, and the dictionary is built from the counts of those symbols.
+ */
+bool digramCtx_buildDict(DigramEncodeContext *ctx, const uint8_t *data, size_t len)
+{
+    if (!ctx || (!data && len != 0))
+        return false;
+
+    for (size_t i = 0; i < ctx->numDigrams; i++)
+        ctx->digramSymbols[ctx->digrams[i]] = 0;
+    memset(ctx->freqs, 0, sizeof(ctx->freqs));
+    memset(ctx->lookup, 0, sizeof(ctx->lookup));
+    ctx->dictSize = 0;
+    ctx->maxLength = 0;
+
+    for (size_t i = 0; i + 1 < len; i++)
+    {
+        const uint16_t digram = (uint16_t)(data[i] << 8 | data[i + 1]);
+        if (ctx->digramCounts[digram]++ == 0)
+            ctx->seenDigrams[ctx->numSeenDigrams++] = digram;
+    }
+    chooseDigrams(ctx);
+
+    for (size_t pos = 0; pos < len;)
+        ctx->freqs[nextSymbol(ctx, data, len, &pos)]++;
+
+    const TreeNode *treeRoot = buildHuffmanTreeInArray(ctx->freqs, DIGRAM_ALPHABET_LEN, ctx->treeNodes);
+    if (!treeRoot)
+        return false;
+
+    HuffmanStringEncoding *entry = ctx->dict;
+    bool success = assignCodes(ctx, treeRoot, 0, 0, &entry);
+    ctx->dictSize = (uint64_t)(entry - ctx->dict) * sizeof(HuffmanStringEncoding);
+    return success;
+}
+
+/**
+ * @brief Get the number of bits the block will take up once encoded
+ */
+uint64_t digramCtx_encodedBits(const DigramEncodeContext *ctx)
+{
+    uint64_t bits = 0;
+    for (size_t symbol = 0; symbol < DIGRAM_ALPHABET_LEN; symbol++)
+    {
+        if (ctx->lookup[symbol])
+            bits += ctx->freqs[symbol] * (uint64_t)ctx->lookup[symbol]->length;
+    }
+    return bits;
+}
+
+/**
+ * @brief Write the dictionary to `out`, which must be able to hold `ctx->dictSize` bytes
+ *
+ * @returns The number of bytes written
+ */
+size_t digramCtx_writeDict(const DigramEncodeContext *ctx, uint8_t *out)
+{
+    memcpy(out, ctx->dict, ctx->dictSize);
+    return ctx->dictSize;
+}
+
+/**
+ * @brief Encode the block the dictionary was built from
+ *
+ * @param[out] out - Must be able to hold `(len * ctx->maxLength + 7) / 8` bytes
+ * @param[out] outLen - Number of bytes written to out
+ */
+bool digramCtx_encodeData(const DigramEncodeContext *ctx, const uint8_t *data, size_t len, uint8_t *out,
+                          size_t *outLen)
+{
+    BitWriter bitWriter;
+    bitWriter_init(&bitWriter, out);
+    for (size_t pos = 0; pos < len;)
+    {
+        const HuffmanStringEncoding *he = ctx->lookup[nextSymbol(ctx, data, len, &pos)];
+        if (!he)
+            return false;
+        bitWriter_putBits(&bitWriter, he->bitStr, he->length);
+    }
+
+    *outLen = bitWriter_flush(&bitWriter);
+    return true;
+}
@@ -0,0 +1,63 @@
+//
+// Extended alphabet: the most frequent digrams of a block become symbols of their own next to the single bytes,
+// so one code can stand for two bytes.
+//
+
+#ifndef DIGRAM_ENCODING_H
+#define DIGRAM_ENCODING_H
+
+#include "huffman_encoding.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DIGRAM_MAX_SYMBOLS 64
+#define DIGRAM_ALPHABET_LEN (ASCII_CHAR_MAP_LEN + DIGRAM_MAX_SYMBOLS)
+#define DIGRAM_TABLE_LEN (UINT16_MAX + 1)
+// A digram has to occur this often in a block to be worth its dictionary entry
+#define DIGRAM_MIN_COUNT 16
+#define STRING_ENCODING_MAX_LEN 3
+
+/**
+ * @brief Dictionary entry of the extended alphabet, the same 16 bytes as `HuffmanEncoding` but the code stands for
+ *        `symLen` bytes instead of a single character
+ */
+typedef struct
+{
+    uint64_t bitStr;
+    int32_t length;
+    uint8_t symLen;
+    uint8_t bytes[STRING_ENCODING_MAX_LEN];
+} HuffmanStringEncoding;
+
+/**
+ * @brief Reusable encoder state for the extended alphabet. Symbols below `ASCII_CHAR_MAP_LEN` are single bytes, the
+ *        ones above are the chosen digrams.
+ */
+typedef struct
+{
+    uint32_t digramCounts[DIGRAM_TABLE_LEN];
+    // Digrams counted at least once, so only those counts need clearing
+    uint16_t seenDigrams[DIGRAM_TABLE_LEN];
+    size_t numSeenDigrams;
+    // Symbol of a chosen digram, 0 for the rest since no digram symbol is below `ASCII_CHAR_MAP_LEN`
+    uint16_t digramSymbols[DIGRAM_TABLE_LEN];
+    uint16_t digrams[DIGRAM_MAX_SYMBOLS];
+    size_t numDigrams;
+    size_t freqs[DIGRAM_ALPHABET_LEN];
+    HuffmanStringEncoding dict[DIGRAM_ALPHABET_LEN];
+    HuffmanStringEncoding *lookup[DIGRAM_ALPHABET_LEN];
+    uint64_t dictSize;
+    int32_t maxLength;
+    TreeNode treeNodes[HUFF_TREE_NODES_LEN(DIGRAM_ALPHABET_LEN)];
+} DigramEncodeContext;
+
+void digramCtx_init(DigramEncodeContext *ctx);
+bool digramCtx_buildDict(DigramEncodeContext *ctx, const uint8_t *data, size_t len);
+uint64_t digramCtx_encodedBits(const DigramEncodeContext *ctx);
+size_t digramCtx_writeDict(const DigramEncodeContext *ctx, uint8_t *out);
+bool digramCtx_encodeData(const DigramEncodeContext *ctx, const uint8_t *data, size_t len, uint8_t *out,
+                          size_t *outLen);
+
+#endif // DIGRAM_ENCODING_H
@@ -1,29 +1,26 @@
+#include "archive.h"
+#include "block_format.h"
 #include "huffman_encoding.h"
 #include "list.h"
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
+#include <unistd.h>
 
 #define BUFFER_LEN 1024
 #define BITS_PER_BYTE 8
-#define ASCII_CHAR_MAP_LEN INT8_MAX + 1
-#define HUFF_ARRAY_LEN INT8_MAX + 1
 #define TEXT_DATA_BUFFER_LEN 1024
-
-/**
- * @brief ASCIICharMap is a wrapper for a size_t array with a defined size of
- * `ASCII_CHAR_MAP_LEN`
- */
-typedef struct
-{
-    size_t map[ASCII_CHAR_MAP_LEN];
-} ASCIICharMap;
+#define STREAM_READ_LEN (64 * 1024)
 
 void freeIov(void *arg)
 {
@@ -93,15 +90,10 @@ bool readFileToLinkedList(char *inputFilePath, LinkedList *outputList, size_t *b
  */
 bool getCharFrequenciesHelper(struct iovec *iov, ASCIICharMap *outputMap)
 {
-    const char *rawIter = (char *)iov->iov_base;
-    const char *const rawTextEnd = (char *)iov->iov_base + iov->iov_len;
+    const uint8_t *rawIter = (uint8_t *)iov->iov_base;
+    const uint8_t *const rawTextEnd = (uint8_t *)iov->iov_base + iov->iov_len;
     while (rawIter != rawTextEnd)
     {
-        if (*rawIter > sizeof(outputMap->map) / sizeof(outputMap->map[0]))
-        {
-            fprintf(stderr, "Character is unable to be stored in frequency map\n");
-            return false;
-        }
         outputMap->map[*rawIter]++;
         rawIter++;
     }
@@ -134,37 +126,6 @@ bool getCharacterFrequencies(LinkedList *inputData, ASCIICharMap *outputMap)
     return true;
 }
 
-/**
- * @brief Create a PriorityQueue from an ASCIICharMap
- *
- * @param[in] inputMap
- * @param[out] outputPriorityQueue
- * @return true
- */
-bool createPriorityQueue(ASCIICharMap *inputMap, LinkedList *outputPriQ)
-{
-    bool isSuccess = true;
-    size_t mapSize = sizeof(inputMap->map) / sizeof(inputMap->map[0]);
-    for (size_t i = 0; i < mapSize; i++)
-    {
-        if (inputMap->map[i] == 0)
-            continue;
-
-        TreeNode *node = (TreeNode *)malloc(sizeof(TreeNode));
-        if (!node)
-        {
-            fprintf(stderr, "Unable to enough memory for new node\n");
-            return false;
-        }
-        node->character = (char)i;
-        node->weight = inputMap->map[i];
-        node->left = NULL;
-        node->right = NULL;
-        isSuccess = llist_insertUsingCompare(outputPriQ, node, treeNode_comparator);
-    }
-    return isSuccess;
-}
-
 bool getHuffmanEncoding(LinkedList *inputFileList, HuffmanEncoding *huffDict, const size_t huffArrayLen,
                         uint64_t *dictSize)
 {
@@ -242,7 +203,7 @@ bool writeDictToFile(FILE *encodedFile, struct iovec *bufIov, size_t *bufOffset,
     uint8_t *buf = bufIov->iov_base;
     size_t bufLen = bufIov->iov_len;
     // Start writing the encoding into the array
-    for (size_t i = 0; i < INT8_MAX; i++)
+    for (size_t i = 0; i < HUFF_ARRAY_LEN; i++)
     {
         if (huffEncodings[i].length == 0)
             continue;
@@ -359,16 +320,312 @@ bool writeEncodedFile(FILE *encodedFile, HuffmanEncoding *dict, uint64_t dictLen
     return success;
 }
 
+/**
+ * @brief Read a stream that has no size up front (pipe, terminal, ...) into a single buffer and encode it
+ */
+static bool encodeStreamedFile(BlockEncoder *enc, FILE *inputFile, FILE *encodedFile)
+{
+    uint8_t *data = NULL;
+    size_t capacity = 0;
+    size_t len = 0;
+    for (;;)
+    {
+        if (len == capacity)
+        {
+            capacity = capacity ? capacity * 2 : STREAM_READ_LEN;
+            uint8_t *grown = (uint8_t *)realloc(data, capacity);
+            if (!grown)
+            {
+                fprintf(stderr, "%s: Unable to allocate %zu bytes for the input\n", __func__, capacity);
+                free(data);
+                return false;
+            }
+            data = grown;
+        }
+        const size_t bytesRead = fread(data + len, 1, capacity - len, inputFile);
+        len += bytesRead;
+        if (bytesRead == 0)
+            break;
+    }
+    if (ferror(inputFile))
+    {
+        fprintf(stderr, "%s: Unable to read input file (errno: %d)\n", __func__, errno);
+        free(data);
+        return false;
+    }
+    bool success = blockEncoder_encodeBufferToFile(enc, data, len, encodedFile);
+    free(data);
+    return success;
+}
+
+/**
+ * @brief Map the whole input file and encode it in one go, a sampled dictionary needs all of the input up front
+ */
+static bool encodeMappedFile(BlockEncoder *enc, FILE *inputFile, FILE *encodedFile)
+{
+    struct stat st;
+    if (fstat(fileno(inputFile), &st) != 0)
+    {
+        fprintf(stderr, "%s: Unable to stat input file (errno: %d)\n", __func__, errno);
+        return false;
+    }
+    // Only regular files have a size to map, anything else is read until end of file
+    if (!S_ISREG(st.st_mode))
+        return encodeStreamedFile(enc, inputFile, encodedFile);
+    const size_t len = (size_t)st.st_size;
+    if (len == 0)
+        return blockEncoder_encodeBufferToFile(enc, NULL, 0, encodedFile);
+
+    void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno(inputFile), 0);
+    if (data == MAP_FAILED)
+    {
+        fprintf(stderr, "%s: Unable to map input file (errno: %d)\n", __func__, errno);
+        return false;
+    }
+    madvise(data, len, MADV_SEQUENTIAL);
+    bool success = blockEncoder_encodeBufferToFile(enc, (const uint8_t *)data, len, encodedFile);
+    munmap(data, len);
+    return success;
+}
+
+/**
+ * @brief Close a file written from scratch and remove it when writing it failed, so no partial output is left
+ *
+ * Buffered writes only fail once the file is closed, so the result of fclose counts as well. Only regular files
+ * are removed, an output like /dev/null or /dev/full stays.
+ *
+ * @returns `success` and whether the file was closed without an error
+ */
+static bool closeOutputFile(FILE *outputFile, const char *outputFilePath, bool success)
+{
+    struct stat st;
+    const bool isRegularFile = fstat(fileno(outputFile), &st) == 0 && S_ISREG(st.st_mode);
+    if (fclose(outputFile) != 0)
+        success = false;
+    if (!success)
+    {
+        fprintf(stderr, "%s: Unable to write file: %s\n", __func__, outputFilePath);
+        if (isRegularFile)
+            remove(outputFilePath);
+    }
+    return success;
+}
+
+/**
+ * @brief Write the encoded file in the block format
+ */
+bool writeBlockFile(const char *inputFilePath, const char *outputFilePath, const BlockEncoderOptions *options)
+{
+    FILE *inputFile = fopen(inputFilePath, "rb");
+    if (!inputFile)
+    {
+        fprintf(stderr, "%s: Unable to open file: %s (errno: %d)\n", __func__, inputFilePath, errno);
+        return false;
+    }
+    FILE *encodedFile = fopen(outputFilePath, "wb");
+    if (!encodedFile)
+    {
+        fprintf(stderr, "%s: Unable to open file: %s (errno: %d)\n", __func__, outputFilePath, errno);
+        fclose(inputFile);
+        return false;
+    }
+
+    BlockEncoder enc;
+    bool success = blockEncoder_init(&enc, options);
+    if (success && options->sampleDict)
+        success = encodeMappedFile(&enc, inputFile, encodedFile);
+    else if (success)
+        success = blockEncoder_encodeFile(&enc, inputFile, encodedFile);
+    success = closeOutputFile(encodedFile, outputFilePath, success);
+    if (success)
+        blockEncoder_printStats(stdout, &enc.stats);
+    blockEncoder_free(&enc);
+    fclose(inputFile);
+    return success;
+}
+
+/**
+ * @brief Add the input to the end of an encoded file in the block format, or write a new one if it doesn't exist
+ *
+ * Only the new data is encoded. Blocks also try the last dictionary of the file, see blockEncoder_openAppend. The
+ * file is locked with flock while appending. On failure the file is cut back to where the new blocks started so it
+ * still decodes.
+ */
+bool appendBlockFile(const char *inputFilePath, const char *outputFilePath, const BlockEncoderOptions *options)
+{
+    FILE *inputFile = fopen(inputFilePath, "rb");
+    if (!inputFile)
+    {
+        fprintf(stderr, "%s: Unable to open file: %s (errno: %d)\n", __func__, inputFilePath, errno);
+        return false;
+    }
+    // Created without truncating, another appender may have just created the file and be writing to it
+    const int encodedFd = open(outputFilePath, O_RDWR | O_CREAT, 0644);
+    FILE *encodedFile = encodedFd >= 0 ? fdopen(encodedFd, "r+b") : NULL;
+    if (!encodedFile)
+    {
+        fprintf(stderr, "%s: Unable to open file: %s (errno: %d)\n", __func__, outputFilePath, errno);
+        if (encodedFd >= 0)
+            close(encodedFd);
+        fclose(inputFile);
+        return false;
+    }
+    // Held until the file is closed, appenders of the same file take turns instead of writing over each other
+    while (flock(encodedFd, LOCK_EX) != 0)
+    {
+        if (errno != EINTR)
+        {
+            fprintf(stderr, "%s: Unable to lock file: %s (errno: %d)\n", __func__, outputFilePath, errno);
+            fclose(encodedFile);
+            fclose(inputFile);
+            return false;
+        }
+    }
+
+    BlockEncoderOptions appendOptions = *options;
+    appendOptions.reuseDict = true;
+    BlockEncoder enc;
+    bool success = blockEncoder_init(&enc, &appendOptions) && blockEncoder_openAppend(&enc, encodedFile);
+    const off_t appendOffset = success ? ftello(encodedFile) : -1;
+    if (success && options->sampleDict)
+        success = encodeMappedFile(&enc, inputFile, encodedFile);
+    else if (success)
+        success = blockEncoder_encodeFile(&enc, inputFile, encodedFile);
+    if (fflush(encodedFile) != 0)
+        success = false;
+    if (!success && appendOffset >= 0 && ftruncate(fileno(encodedFile), appendOffset) != 0)
+        fprintf(stderr, "%s: Unable to remove the partly appended blocks (errno: %d)\n", __func__, errno);
+    if (success)
+        blockEncoder_printStats(stdout, &enc.stats);
+    blockEncoder_free(&enc);
+    if (fclose(encodedFile) != 0)
+        success = false;
+    fclose(inputFile);
+    return success;
+}
+
+static bool parseBackend(const char *name, BlockBackend *backend)
+{
+    if (strcmp(name, "huffman") == 0)
+        *backend = BLOCK_BACKEND_HUFFMAN;
+    else if (strcmp(name, "tans") == 0)
+        *backend = BLOCK_BACKEND_TANS;
+    else if (strcmp(name, "auto") == 0)
+        *backend = BLOCK_BACKEND_AUTO;
+    else
+        return false;
+    return true;
+}
+
+static void printUsage(const char *progName)
+{
+    fprintf(stderr, "Usage: %s [-L] [-A] [-c] [-C] [-d] [-e backend] [-f] <inputFile> <outputFile>\n", progName);
+    fprintf(stderr, "       -L writes the single dictionary format instead of the block format, the only one the\n");
+    fprintf(stderr, "          Rust decoder reads\n");
+    fprintf(stderr, "       -c adds a CRC32C of every block\n");
+    fprintf(stderr, "       -C also tries a dictionary per class of the previous character for every block\n");
+    fprintf(stderr, "       -d also tries the most frequent digrams of every block as extra symbols\n");
+    fprintf(stderr, "       -e huffman|tans|auto picks the entropy coder, auto keeps the smaller per block\n");
+    fprintf(stderr, "       -f encodes every block with one dictionary built from a sample of the input, only\n");
+    fprintf(stderr, "          with -e huffman and without -C or -d\n");
+    fprintf(stderr, "       -A appends to outputFile under flock, blocks reuse its last dictionary when that's\n");
+    fprintf(stderr, "          smaller and -c is taken from the file\n");
+    fprintf(stderr, "       %s -a <archiveFile> [-j threads] [-c] [-C] [-d] [-e backend] [-f] <inputFiles...>\n",
+            progName);
+}
+
 int main(int argc, char **argv)
 {
-    if (argc < 3)
+    const char *archivePath = NULL;
+    bool legacyFormat = false;
+    bool append = false;
+    BlockEncoderOptions options = {.fileFlags = 0,
+                                   .backend = BLOCK_BACKEND_HUFFMAN,
+                                   .useContexts = false,
+                                   .useDigrams = false,
+                                   .sampleDict = false,
+                                   .reuseDict = false};
+    long numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt(argc, argv, "a:j:LAcCde:f")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            archivePath = optarg;
+            break;
+        case 'j':
+            numThreads = strtol(optarg, NULL, 10);
+            break;
+        case 'L':
+            legacyFormat = true;
+            break;
+        case 'A':
+            append = true;
+            break;
+        case 'c':
+            options.fileFlags |= BLOCK_FILE_FLAG_CRC32C;
+            break;
+        case 'C':
+            options.useContexts = true;
+            break;
+        case 'd':
+            options.useDigrams = true;
+            break;
+        case 'f':
+            options.sampleDict = true;
+            break;
+        case 'e':
+            if (!parseBackend(optarg, &options.backend))
+            {
+                fprintf(stderr, "Unknown backend: %s\n", optarg);
+                printUsage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!blockEncoder_validOptions(&options))
+    {
+        fprintf(stderr, "-f only goes with -e huffman, without -C or -d\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (archivePath)
+    {
+        if (optind >= argc)
+        {
+            fprintf(stderr, "Need to specify files to archive\n");
+            return 1;
+        }
+        size_t threads = numThreads > 0 ? (size_t)numThreads : 1;
+        return archive_write(archivePath, argv + optind, (size_t)(argc - optind), threads, &options) ? 0 : 1;
+    }
+
+    if (argc - optind < 2)
     {
         fprintf(stderr, "Need to specify a file to encode\n");
         fprintf(stderr, "Need to specify file to write data into\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+    char *inputFilePath = argv[optind];
+    char *outputFilePath = argv[optind + 1];
+    if (append && legacyFormat)
+    {
+        fprintf(stderr, "Only the block format can be appended to\n");
         return 1;
     }
-    char *inputFilePath = argv[1];
-    char *outputFilePath = argv[2];
+    if (append)
+        return appendBlockFile(inputFilePath, outputFilePath, &options) ? 0 : 1;
+    if (!legacyFormat)
+        return writeBlockFile(inputFilePath, outputFilePath, &options) ? 0 : 1;
+
     LinkedList inputFileList = {.head = NULL, .tail = NULL};
 
     uint64_t originalFileSize = 0;
@@ -396,18 +653,23 @@ int main(int argc, char **argv)
     if (!success)
     {
         fprintf(stderr, "Failed to get huffman encoding\n");
+        free(huffEncodings);
+        llist_free(&inputFileList, freeIov);
         return 1;
     }
     printf("dictSize: %lu\n", dictSize);
 
     FILE *encodedFile = fopen(outputFilePath, "wb");
-    success = writeEncodedFile(encodedFile, huffEncodings, dictSize, &inputFileList, originalFileSize);
-    fclose(encodedFile);
-    free(huffEncodings);
-    if (!success)
+    if (!encodedFile)
     {
-        fprintf(stderr, "Failed to write encoded file: %s", outputFilePath);
+        fprintf(stderr, "Unable to open file: %s (errno: %d)\n", outputFilePath, errno);
+        free(huffEncodings);
+        llist_free(&inputFileList, freeIov);
         return 1;
     }
-    return 0;
+    success = writeEncodedFile(encodedFile, huffEncodings, dictSize, &inputFileList, originalFileSize);
+    success = closeOutputFile(encodedFile, outputFilePath, success);
+    free(huffEncodings);
+    llist_free(&inputFileList, freeIov);
+    return success ? 0 : 1;
 }
@@ -0,0 +1,268 @@
+#include "huffman_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ENCODING_HDR_LEN (2 * sizeof(uint64_t))
+
+/**
+ * @brief Monotonic clock in nanoseconds, the clock of all batch timings
+ */
+uint64_t huffBatch_nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static size_t writeEncodingHdr(uint8_t *buf, uint64_t originalLen, uint64_t dictSize)
+{
+    memcpy(buf, &originalLen, sizeof(originalLen));
+    memcpy(buf + sizeof(originalLen), &dictSize, sizeof(dictSize));
+    return ENCODING_HDR_LEN;
+}
+
+static bool reserveScratch(HuffBatch *batch, size_t len)
+{
+    if (batch->scratchLen >= len)
+        return true;
+
+    uint8_t *scratch = (uint8_t *)realloc(batch->scratch, len);
+    if (!scratch)
+    {
+        fprintf(stderr, "%s: Unable to grow scratch buffer to %zu bytes\n", __func__, len);
+        return false;
+    }
+    batch->scratch = scratch;
+    batch->scratchLen = len;
+    return true;
+}
+
+void huffBatch_init(HuffBatch *batch)
+{
+    huffCtx_init(&batch->encodeCtx);
+    batch->scratch = NULL;
+    batch->scratchLen = 0;
+    batch->sharedDict = false;
+}
+
+void huffBatch_free(HuffBatch *batch)
+{
+    free(batch->scratch);
+    huffBatch_init(batch);
+}
+
+/**
+ * @brief Compress a single buffer with its own dictionary
+ *
+ * @param[in] input - The buffer to compress
+ * @param[out] output - Allocated to exactly the size of the compressed buffer, free with `free(output->iov_base)`
+ * @param[out] itemStats - Optional
+ */
+bool huffBatch_compressOne(HuffBatch *batch, const struct iovec *input, struct iovec *output,
+                           HuffBatchItemStats *itemStats)
+{
+    if (!batch || !input || !output)
+        return false;
+
+    const uint64_t start = huffBatch_nowNs();
+    HuffEncodeContext *ctx = &batch->encodeCtx;
+    const uint8_t *inputData = (const uint8_t *)input->iov_base;
+    huffCtx_reset(ctx);
+    batch->sharedDict = false;
+
+    if (input->iov_len != 0)
+    {
+        huffCtx_countFrequencies(ctx, inputData, input->iov_len);
+        if (!huffCtx_buildDict(ctx))
+            return false;
+    }
+
+    const size_t dataLen = (size_t)((huffCtx_encodedBits(ctx) + 7) / 8);
+    const size_t outputLen = ENCODING_HDR_LEN + ctx->dictSize + dataLen;
+    uint8_t *out = (uint8_t *)malloc(outputLen);
+    if (!out)
+    {
+        fprintf(stderr, "%s: Unable to allocate output\n", __func__);
+        return false;
+    }
+
+    size_t offset = writeEncodingHdr(out, input->iov_len, ctx->dictSize);
+    offset += huffCtx_writeDict(ctx, out + offset);
+    size_t encodedLen = 0;
+    if (!huffCtx_encodeData(ctx, inputData, input->iov_len, out + offset, &encodedLen))
+    {
+        free(out);
+        return false;
+    }
+
+    output->iov_base = out;
+    output->iov_len = offset + encodedLen;
+    if (itemStats)
+    {
+        itemStats->bytesIn = input->iov_len;
+        itemStats->bytesOut = output->iov_len;
+        itemStats->elapsedNs = huffBatch_nowNs() - start;
+    }
+    return true;
+}
+
+static bool compressWithSharedDict(HuffBatch *batch, const struct iovec *input, struct iovec *output,
+                                   HuffBatchItemStats *itemStats)
+{
+    const uint64_t start = huffBatch_nowNs();
+    const HuffEncodeContext *ctx = &batch->encodeCtx;
+    const size_t boundLen = ENCODING_HDR_LEN + (input->iov_len * (size_t)ctx->maxLength + 7) / 8;
+    if (!reserveScratch(batch, boundLen))
+        return false;
+
+    size_t offset = writeEncodingHdr(batch->scratch, input->iov_len, 0);
+    size_t encodedLen = 0;
+    if (!huffCtx_encodeData(ctx, (const uint8_t *)input->iov_base, input->iov_len, batch->scratch + offset,
+                            &encodedLen))
+        return false;
+
+    const size_t outputLen = offset + encodedLen;
+    uint8_t *out = (uint8_t *)malloc(outputLen);
+    if (!out)
+    {
+        fprintf(stderr, "%s: Unable to allocate output\n", __func__);
+        return false;
+    }
+    memcpy(out, batch->scratch, outputLen);
+
+    output->iov_base = out;
+    output->iov_len = outputLen;
+    if (itemStats)
+    {
+        itemStats->bytesIn = input->iov_len;
+        itemStats->bytesOut = outputLen;
+        itemStats->elapsedNs = huffBatch_nowNs() - start;
+    }
+    return true;
+}
+
+/**
+ * @brief Compress every buffer of `inputs` into the matching entry of `outputs`
+ *
+ * @param[in] inputs - Buffers to compress
+ * @param[in] count - Number of entries in inputs, outputs and itemStats
+ * @param[in] shareDict - Build one dictionary from all inputs instead of one per input
+ * @param[out] outputs - Free with `huffBatch_freeOutputs`. Nothing is left allocated on failure
+ * @param[out] itemStats - Optional, per item sizes and timings
+ * @param[out] stats - Optional, totals for the whole batch
+ */
+bool huffBatch_compress(HuffBatch *batch, const struct iovec *inputs, size_t count, bool shareDict,
+                        struct iovec *outputs, HuffBatchItemStats *itemStats, HuffBatchStats *stats)
+{
+    if (!batch || !inputs || !outputs)
+        return false;
+
+    const uint64_t start = huffBatch_nowNs();
+    uint64_t setupNs = 0;
+    if (shareDict)
+    {
+        HuffEncodeContext *ctx = &batch->encodeCtx;
+        huffCtx_reset(ctx);
+        batch->sharedDict = false;
+        uint64_t totalLen = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            huffCtx_countFrequencies(ctx, (const uint8_t *)inputs[i].iov_base, inputs[i].iov_len);
+            totalLen += inputs[i].iov_len;
+        }
+        // Without any input the shared dictionary stays empty, like the one of an empty item
+        if (totalLen != 0 && !huffCtx_buildDict(ctx))
+            return false;
+        batch->sharedDict = true;
+        setupNs = huffBatch_nowNs() - start;
+    }
+
+    HuffBatchStats totals = {.itemCount = count, .setupNs = setupNs};
+    for (size_t i = 0; i < count; i++)
+    {
+        HuffBatchItemStats *curStats = itemStats ? &itemStats[i] : NULL;
+        bool success = shareDict ? compressWithSharedDict(batch, &inputs[i], &outputs[i], curStats)
+                                 : huffBatch_compressOne(batch, &inputs[i], &outputs[i], curStats);
+        if (!success)
+        {
+            fprintf(stderr, "%s: Failed to compress item %zu\n", __func__, i);
+            huffBatch_freeOutputs(outputs, i);
+            return false;
+        }
+        totals.bytesIn += inputs[i].iov_len;
+        totals.bytesOut += outputs[i].iov_len;
+    }
+    totals.elapsedNs = huffBatch_nowNs() - start;
+
+    if (stats)
+        *stats = totals;
+    return true;
+}
+
+/**
+ * @brief Copy the dictionary the last `huffBatch_compress` call shared between its items
+ *
+ * @param[out] dict - Free with `free(dict->iov_base)`, empty when every item of the batch was empty
+ */
+bool huffBatch_copySharedDict(const HuffBatch *batch, struct iovec *dict)
+{
+    if (!batch || !dict || !batch->sharedDict)
+        return false;
+
+    dict->iov_base = NULL;
+    dict->iov_len = 0;
+    if (batch->encodeCtx.dictSize == 0)
+        return true;
+
+    dict->iov_base = malloc(batch->encodeCtx.dictSize);
+    if (!dict->iov_base)
+        return false;
+    dict->iov_len = huffCtx_writeDict(&batch->encodeCtx, (uint8_t *)dict->iov_base);
+    return true;
+}
+
+void huffBatch_freeOutputs(struct iovec *outputs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        free(outputs[i].iov_base);
+        outputs[i].iov_base = NULL;
+        outputs[i].iov_len = 0;
+    }
+}
+
+static double mbPerSec(uint64_t bytes, uint64_t ns)
+{
+    return ns ? (double)bytes * 1000.0 / (double)ns : 0.0;
+}
+
+void huffBatch_printStats(FILE *stream, const HuffBatchStats *stats, const HuffBatchItemStats *itemStats,
+                          size_t count)
+{
+    fprintf(stream, "Items         : %zu\n", stats->itemCount);
+    fprintf(stream, "Bytes In      : %lu\n", stats->bytesIn);
+    fprintf(stream, "Bytes Out     : %lu (%.2f%%)\n", stats->bytesOut,
+            stats->bytesIn ? 100.0 * (double)stats->bytesOut / (double)stats->bytesIn : 0.0);
+    fprintf(stream, "Setup         : %lu ns\n", stats->setupNs);
+    fprintf(stream, "Throughput    : %.2f MB/s\n", mbPerSec(stats->bytesIn, stats->elapsedNs));
+
+    if (!itemStats || count == 0)
+        return;
+
+    uint64_t minNs = UINT64_MAX;
+    uint64_t maxNs = 0;
+    uint64_t totalNs = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (itemStats[i].elapsedNs < minNs)
+            minNs = itemStats[i].elapsedNs;
+        if (itemStats[i].elapsedNs > maxNs)
+            maxNs = itemStats[i].elapsedNs;
+        totalNs += itemStats[i].elapsedNs;
+    }
+    fprintf(stream, "Item Latency  : min %lu ns, avg %lu ns, max %lu ns\n", minNs, totalNs / count, maxNs);
+    fprintf(stream, "Item Throughput: %.2f MB/s\n", mbPerSec(stats->bytesIn, totalNs));
+}
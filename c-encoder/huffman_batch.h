@@ -0,0 +1,60 @@
+//
+// Batch encoding of many small buffers.
+//
+
+#ifndef HUFFMAN_BATCH_H
+#define HUFFMAN_BATCH_H
+
+#include "huffman_encoding.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/uio.h>
+
+typedef struct
+{
+    size_t bytesIn;
+    size_t bytesOut;
+    uint64_t elapsedNs;
+} HuffBatchItemStats;
+
+typedef struct
+{
+    size_t itemCount;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint64_t setupNs;
+    uint64_t elapsedNs;
+} HuffBatchStats;
+
+/**
+ * @brief State that is kept between the items of a batch (and between batches).
+ *
+ * Every output is in the single dictionary format written by `encoding -L`, not the block format, and has no stored
+ * fallback so it can be larger than its input. When the batch is compressed with a shared dictionary the
+ * `Dictionary Len` of every output is 0 and the dictionary has to be fetched once with `huffBatch_copySharedDict`.
+ */
+typedef struct
+{
+    HuffEncodeContext encodeCtx;
+    uint8_t *scratch;
+    size_t scratchLen;
+    bool sharedDict;
+} HuffBatch;
+
+void huffBatch_init(HuffBatch *batch);
+void huffBatch_free(HuffBatch *batch);
+
+bool huffBatch_compressOne(HuffBatch *batch, const struct iovec *input, struct iovec *output,
+                           HuffBatchItemStats *itemStats);
+bool huffBatch_compress(HuffBatch *batch, const struct iovec *inputs, size_t count, bool shareDict,
+                        struct iovec *outputs, HuffBatchItemStats *itemStats, HuffBatchStats *stats);
+bool huffBatch_copySharedDict(const HuffBatch *batch, struct iovec *dict);
+void huffBatch_freeOutputs(struct iovec *outputs, size_t count);
+
+uint64_t huffBatch_nowNs(void);
+void huffBatch_printStats(FILE *stream, const HuffBatchStats *stats, const HuffBatchItemStats *itemStats,
+                          size_t count);
+
+#endif // HUFFMAN_BATCH_H
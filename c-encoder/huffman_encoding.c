@@ -1,6 +1,8 @@
 #include "huffman_encoding.h"
+#include "bit_writer.h"
 
 #include <stdio.h>
+#include <string.h>
 
 bool treeNode_comparator(void *tn0, void *tn1)
 {
@@ -32,6 +34,7 @@ bool buildHuffmanTree(LinkedList *priorityQueue, TreeNode **rootPtr)
             return false;
         }
         newNode->character = '\0';
+        newNode->symbol = 0;
         newNode->weight = leftNode->weight + rightNode->weight;
         newNode->left = leftNode;
         newNode->right = rightNode;
@@ -43,6 +46,69 @@ bool buildHuffmanTree(LinkedList *priorityQueue, TreeNode **rootPtr)
     return true;
 }
 
+/**
+ * @brief Build a Huffman tree in `nodes` with the two queue method instead of a linked list of allocated nodes
+ *
+ * The leaves are sorted by weight as they are added. Every merge creates a node at least as heavy as the one before
+ * it, so the internal nodes come out sorted as well and the two lightest nodes are always at the front of one of the
+ * two queues.
+ *
+ * @param[in] weights - Weight of every symbol, indexed by symbol
+ * @param[in] numSymbols - Length of weights
+ * @param[out] nodes - Must be able to hold `HUFF_TREE_NODES_LEN(numSymbols)` nodes
+ * @returns The root of the tree, NULL if every weight is 0
+ */
+TreeNode *buildHuffmanTreeInArray(const size_t *weights, size_t numSymbols, TreeNode *nodes)
+{
+    size_t numLeaves = 0;
+    for (size_t i = 0; i < numSymbols; i++)
+    {
+        if (weights[i] == 0)
+            continue;
+
+        // Insertion sort by weight, there are few leaves and qsort may allocate its merge buffer
+        size_t pos = numLeaves++;
+        while (pos > 0 && nodes[pos - 1].weight > weights[i])
+        {
+            nodes[pos] = nodes[pos - 1];
+            pos--;
+        }
+        TreeNode *leaf = &nodes[pos];
+        leaf->character = (char)i;
+        leaf->symbol = (uint16_t)i;
+        leaf->weight = weights[i];
+        leaf->left = NULL;
+        leaf->right = NULL;
+    }
+    if (numLeaves == 0)
+        return NULL;
+
+    size_t nextLeaf = 0;
+    size_t nextInternal = numLeaves;
+    size_t numNodes = numLeaves;
+    while (numNodes < HUFF_TREE_NODES_LEN(numLeaves))
+    {
+        TreeNode *children[2];
+        for (size_t c = 0; c < 2; c++)
+        {
+            // Leaves win ties, which keeps the longest code as short as possible
+            if (nextLeaf < numLeaves &&
+                (nextInternal == numNodes || nodes[nextLeaf].weight <= nodes[nextInternal].weight))
+                children[c] = &nodes[nextLeaf++];
+            else
+                children[c] = &nodes[nextInternal++];
+        }
+
+        TreeNode *newNode = &nodes[numNodes++];
+        newNode->character = '\0';
+        newNode->symbol = 0;
+        newNode->weight = children[0]->weight + children[1]->weight;
+        newNode->left = children[0];
+        newNode->right = children[1];
+    }
+    return &nodes[numNodes - 1];
+}
+
 bool generateHuffmanEncodings(TreeNode *root, HuffmanEncoding *curEncoding, HuffmanEncoding **const begin,
                               HuffmanEncoding *const end)
 {
@@ -86,6 +152,267 @@ bool generateHuffmanEncodings(TreeNode *root, HuffmanEncoding *curEncoding, Huff
     return isSuccessful;
 }
 
+/**
+ * @brief Create a PriorityQueue from an ASCIICharMap
+ *
+ * @param[in] inputMap
+ * @param[out] outputPriorityQueue
+ * @return true
+ */
+bool createPriorityQueue(ASCIICharMap *inputMap, LinkedList *outputPriQ)
+{
+    size_t mapSize = sizeof(inputMap->map) / sizeof(inputMap->map[0]);
+    return createSymbolPriorityQueue(inputMap->map, mapSize, outputPriQ);
+}
+
+/**
+ * @brief Create a PriorityQueue with a leaf for every symbol with a non zero weight
+ *
+ * @param[in] weights - Weight of every symbol, indexed by symbol
+ * @param[in] numSymbols - Length of weights
+ * @param[out] outputPriorityQueue
+ */
+bool createSymbolPriorityQueue(const size_t *weights, size_t numSymbols, LinkedList *outputPriQ)
+{
+    bool isSuccess = true;
+    for (size_t i = 0; i < numSymbols; i++)
+    {
+        if (weights[i] == 0)
+            continue;
+
+        TreeNode *node = (TreeNode *)malloc(sizeof(TreeNode));
+        if (!node)
+        {
+            fprintf(stderr, "Unable to enough memory for new node\n");
+            return false;
+        }
+        node->character = (char)i;
+        node->symbol = (uint16_t)i;
+        node->weight = weights[i];
+        node->left = NULL;
+        node->right = NULL;
+        isSuccess = llist_insertUsingCompare(outputPriQ, node, treeNode_comparator);
+    }
+    return isSuccess;
+}
+
+void huffCtx_init(HuffEncodeContext *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+/**
+ * @brief Clear the context so that it can be used for the next input.
+ *
+ * Once a dictionary has been built every counted character has an entry in it, so only those entries need to be
+ * cleared. Otherwise the whole map is cleared.
+ */
+void huffCtx_reset(HuffEncodeContext *ctx)
+{
+    if (!ctx->dictBuilt)
+    {
+        huffCtx_init(ctx);
+        return;
+    }
+
+    const size_t numEntries = ctx->dictSize / sizeof(HuffmanEncoding);
+    for (size_t i = 0; i < numEntries; i++)
+    {
+        uint8_t c = (uint8_t)ctx->dict[i].character;
+        ctx->charMap.map[c] = 0;
+        ctx->lookup[c] = NULL;
+    }
+    memset(ctx->dict, 0, ctx->dictSize);
+    ctx->dictSize = 0;
+    ctx->maxLength = 0;
+    ctx->dictBuilt = false;
+}
+
+/**
+ * @brief Add the characters of a buffer to the frequency map of the context
+ */
+void huffCtx_countFrequencies(HuffEncodeContext *ctx, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        ctx->charMap.map[data[i]]++;
+}
+
+/**
+ * @brief Build the dictionary and character lookup table from the frequencies counted so far
+ */
+bool huffCtx_buildDict(HuffEncodeContext *ctx)
+{
+    TreeNode *treeRoot = buildHuffmanTreeInArray(ctx->charMap.map, ASCII_CHAR_MAP_LEN, ctx->treeNodes);
+    if (!treeRoot)
+    {
+        fprintf(stderr, "%s: No characters counted\n", __func__);
+        return false;
+    }
+
+    HuffmanEncoding initialEncoding = {.bitStr = 0, .length = 0, .character = 0};
+    HuffmanEncoding *huffIter = ctx->dict;
+    if (!generateHuffmanEncodings(treeRoot, &initialEncoding, &huffIter, ctx->dict + HUFF_ARRAY_LEN))
+        return false;
+
+    // A single distinct character ends up as the root of the tree, give it a one bit code so it can be written
+    if (huffIter - ctx->dict == 1)
+        ctx->dict[0].length = 1;
+
+    ctx->dictSize = (uint64_t)(huffIter - ctx->dict) * sizeof(HuffmanEncoding);
+    ctx->maxLength = 0;
+    for (HuffmanEncoding *he = ctx->dict; he != huffIter; he++)
+    {
+        ctx->lookup[(uint8_t)he->character] = he;
+        if (he->length > ctx->maxLength)
+            ctx->maxLength = he->length;
+    }
+    ctx->dictBuilt = true;
+    return true;
+}
+
+/**
+ * @brief Use a dictionary written by `huffCtx_writeDict` instead of building one. The frequencies are left empty.
+ *
+ * @returns false if the dictionary isn't a whole number of entries, has more than `HUFF_ARRAY_LEN` of them, has a
+ *          code length that doesn't fit `bitStr` or has a character twice
+ */
+bool huffCtx_loadDict(HuffEncodeContext *ctx, const uint8_t *dict, size_t dictLen)
+{
+    huffCtx_reset(ctx);
+    if (dictLen % sizeof(HuffmanEncoding) != 0 || dictLen > sizeof(ctx->dict))
+    {
+        fprintf(stderr, "%s: Invalid dictionary length: %zu\n", __func__, dictLen);
+        return false;
+    }
+
+    memcpy(ctx->dict, dict, dictLen);
+    const size_t numEntries = dictLen / sizeof(HuffmanEncoding);
+    for (size_t i = 0; i < numEntries; i++)
+    {
+        HuffmanEncoding *he = &ctx->dict[i];
+        const uint8_t c = (uint8_t)he->character;
+        if (he->length <= 0 || he->length > (int32_t)(sizeof(he->bitStr) * BITS_PER_BYTE) || ctx->lookup[c])
+        {
+            fprintf(stderr, "%s: Invalid dictionary entry %zu\n", __func__, i);
+            huffCtx_init(ctx);
+            return false;
+        }
+        ctx->lookup[c] = he;
+        if (he->length > ctx->maxLength)
+            ctx->maxLength = he->length;
+    }
+    ctx->dictSize = dictLen;
+    ctx->dictBuilt = true;
+    return true;
+}
+
+/**
+ * @brief Get the number of bits the counted frequencies will take up once encoded
+ */
+uint64_t huffCtx_encodedBits(const HuffEncodeContext *ctx)
+{
+    uint64_t bits = 0;
+    const size_t numEntries = ctx->dictSize / sizeof(HuffmanEncoding);
+    for (size_t i = 0; i < numEntries; i++)
+        bits += ctx->charMap.map[(uint8_t)ctx->dict[i].character] * (uint64_t)ctx->dict[i].length;
+    return bits;
+}
+
+/**
+ * @brief Write the dictionary to `out`, which must be able to hold `ctx->dictSize` bytes
+ *
+ * @returns The number of bytes written
+ */
+size_t huffCtx_writeDict(const HuffEncodeContext *ctx, uint8_t *out)
+{
+    memcpy(out, ctx->dict, ctx->dictSize);
+    return ctx->dictSize;
+}
+
+/**
+ * @brief Encode a buffer with the dictionary of the context
+ *
+ * @param[in] data - The data to encode
+ * @param[in] len - Length of data
+ * @param[out] out - Must be able to hold `(len * ctx->maxLength + 7) / 8` bytes
+ * @param[out] outLen - Number of bytes written to out
+ * @returns false if a character of data has no encoding
+ */
+bool huffCtx_encodeData(const HuffEncodeContext *ctx, const uint8_t *data, size_t len, uint8_t *out,
+                        size_t *outLen)
+{
+    BitWriter bitWriter;
+    bitWriter_init(&bitWriter, out);
+    for (size_t i = 0; i < len; i++)
+    {
+        const HuffmanEncoding *he = ctx->lookup[data[i]];
+        if (!he)
+            return false;
+        bitWriter_putBits(&bitWriter, he->bitStr, he->length);
+    }
+
+    *outLen = bitWriter_flush(&bitWriter);
+    return true;
+}
+
+/**
+ * @brief Get the context class of the character preceding the one being encoded
+ */
+uint8_t huffCtx_contextClass(uint8_t prevChar)
+{
+    if (prevChar >= 'a' && prevChar <= 'z')
+        return strchr("aeiou", prevChar) ? HUFF_CONTEXT_VOWEL : HUFF_CONTEXT_LOWER;
+    if (prevChar >= 'A' && prevChar <= 'Z')
+        return HUFF_CONTEXT_UPPER;
+    if (prevChar >= '0' && prevChar <= '9')
+        return HUFF_CONTEXT_DIGIT;
+    if (prevChar == ' ' || prevChar == '\t')
+        return HUFF_CONTEXT_SPACE;
+    if (prevChar == '\n' || prevChar == '\r')
+        return HUFF_CONTEXT_NEWLINE;
+    if (prevChar > ' ' && prevChar < 0x7f)
+        return HUFF_CONTEXT_PUNCT;
+    return HUFF_CONTEXT_OTHER;
+}
+
+/**
+ * @brief Count frequencies into `ctxs[contextClasses[previous character]]`. The first character of the buffer
+ *        follows a 0.
+ */
+void huffCtx_countFrequenciesOrder1(HuffEncodeContext *ctxs, const uint8_t *contextClasses, const uint8_t *data,
+                                    size_t len)
+{
+    uint8_t prevChar = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        ctxs[contextClasses[prevChar]].charMap.map[data[i]]++;
+        prevChar = data[i];
+    }
+}
+
+/**
+ * @brief Encode a buffer, switching to the dictionary of the context class of the previous character for every
+ *        character. The same rules as `huffCtx_encodeData` apply to `out`, using the longest code of all `ctxs`.
+ */
+bool huffCtx_encodeDataOrder1(const HuffEncodeContext *ctxs, const uint8_t *contextClasses, const uint8_t *data,
+                              size_t len, uint8_t *out, size_t *outLen)
+{
+    BitWriter bitWriter;
+    bitWriter_init(&bitWriter, out);
+    uint8_t prevChar = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        const HuffmanEncoding *he = ctxs[contextClasses[prevChar]].lookup[data[i]];
+        if (!he)
+            return false;
+        bitWriter_putBits(&bitWriter, he->bitStr, he->length);
+        prevChar = data[i];
+    }
+
+    *outLen = bitWriter_flush(&bitWriter);
+    return true;
+}
+
 void freeHuffmanTree(TreeNode *root)
 {
     if (!root)
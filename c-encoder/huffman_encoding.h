@@ -8,12 +8,29 @@
 #include "list.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#define ASCII_CHAR_MAP_LEN (UINT8_MAX + 1)
+#define HUFF_ARRAY_LEN (UINT8_MAX + 1)
+// Nodes of a Huffman tree with `numSymbols` leaves
+#define HUFF_TREE_NODES_LEN(numSymbols) (2 * (numSymbols) - 1)
+
+/**
+ * @brief ASCIICharMap is a wrapper for a size_t array with a defined size of
+ * `ASCII_CHAR_MAP_LEN`
+ */
+typedef struct
+{
+    size_t map[ASCII_CHAR_MAP_LEN];
+} ASCIICharMap;
+
 typedef struct TreeNode
 {
     char character;
+    // Index of the symbol in the weights the tree was built from, equal to `character` for single bytes
+    uint16_t symbol;
     size_t weight;
     struct TreeNode *left;
     struct TreeNode *right;
@@ -26,11 +43,65 @@ typedef struct
     char character;
 } HuffmanEncoding;
 
+/**
+ * @brief Classes of the previous character used to pick a dictionary when encoding with order-1 contexts
+ */
+typedef enum
+{
+    HUFF_CONTEXT_OTHER = 0,
+    HUFF_CONTEXT_SPACE,
+    HUFF_CONTEXT_NEWLINE,
+    HUFF_CONTEXT_VOWEL,
+    HUFF_CONTEXT_LOWER,
+    HUFF_CONTEXT_UPPER,
+    HUFF_CONTEXT_DIGIT,
+    HUFF_CONTEXT_PUNCT,
+    HUFF_CONTEXT_CLASSES,
+} HuffContextClass;
+
+/**
+ * @brief Reusable encoder state for in-memory encoding.
+ *
+ * Keeping one of these around between inputs avoids re-allocating the dictionary for every buffer and lets
+ * `huffCtx_reset` clear only the frequency entries the previous input touched instead of the whole map.
+ */
+typedef struct
+{
+    ASCIICharMap charMap;
+    HuffmanEncoding dict[HUFF_ARRAY_LEN];
+    HuffmanEncoding *lookup[ASCII_CHAR_MAP_LEN];
+    uint64_t dictSize;
+    int32_t maxLength;
+    bool dictBuilt;
+    // Scratch space of `huffCtx_buildDict`, nothing is allocated per dictionary
+    TreeNode treeNodes[HUFF_TREE_NODES_LEN(ASCII_CHAR_MAP_LEN)];
+} HuffEncodeContext;
+
 bool treeNode_comparator(void *tn0, void *tn1);
 bool buildHuffmanTree(LinkedList *priorityQueue, TreeNode **rootPtr);
+TreeNode *buildHuffmanTreeInArray(const size_t *weights, size_t numSymbols, TreeNode *nodes);
 bool generateHuffmanEncodings(TreeNode *root, HuffmanEncoding *curEncoding, HuffmanEncoding **const begin,
                               HuffmanEncoding *const end);
 
+bool createPriorityQueue(ASCIICharMap *inputMap, LinkedList *outputPriQ);
+bool createSymbolPriorityQueue(const size_t *weights, size_t numSymbols, LinkedList *outputPriQ);
+
+void huffCtx_init(HuffEncodeContext *ctx);
+void huffCtx_reset(HuffEncodeContext *ctx);
+void huffCtx_countFrequencies(HuffEncodeContext *ctx, const uint8_t *data, size_t len);
+bool huffCtx_buildDict(HuffEncodeContext *ctx);
+bool huffCtx_loadDict(HuffEncodeContext *ctx, const uint8_t *dict, size_t dictLen);
+uint64_t huffCtx_encodedBits(const HuffEncodeContext *ctx);
+size_t huffCtx_writeDict(const HuffEncodeContext *ctx, uint8_t *out);
+bool huffCtx_encodeData(const HuffEncodeContext *ctx, const uint8_t *data, size_t len, uint8_t *out,
+                        size_t *outLen);
+
+uint8_t huffCtx_contextClass(uint8_t prevChar);
+void huffCtx_countFrequenciesOrder1(HuffEncodeContext *ctxs, const uint8_t *contextClasses, const uint8_t *data,
+                                    size_t len);
+bool huffCtx_encodeDataOrder1(const HuffEncodeContext *ctxs, const uint8_t *contextClasses, const uint8_t *data,
+                              size_t len, uint8_t *out, size_t *outLen);
+
 void printHuffmanEncodings(TreeNode *root, HuffmanEncoding *curEncoding);
 void freeHuffmanTree(TreeNode *root);
 void freeHuffmanTreeCb(void *root);
@@ -0,0 +1,174 @@
+#include "tans.h"
+#include "bit_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static inline uint32_t highBit(uint32_t value)
+{
+    return value == 0 ? 0 : 31 - (uint32_t)__builtin_clz(value);
+}
+
+void tans_init(TansEncoder *tans)
+{
+    memset(tans->normCounts, 0, sizeof(tans->normCounts));
+    tans->numSymbols = 0;
+    tans->pending = NULL;
+    tans->pendingLen = 0;
+}
+
+void tans_free(TansEncoder *tans)
+{
+    free(tans->pending);
+    tans->pending = NULL;
+    tans->pendingLen = 0;
+}
+
+/**
+ * @brief Scale the frequencies so they add up to `TANS_TABLE_LEN`, every symbol that occurs keeps at least 1
+ */
+static bool normalizeCounts(TansEncoder *tans, const ASCIICharMap *charMap)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < ASCII_CHAR_MAP_LEN; i++)
+        total += charMap->map[i];
+    if (total == 0)
+        return false;
+
+    uint32_t sum = 0;
+    size_t largest = 0;
+    tans->numSymbols = 0;
+    for (size_t i = 0; i < ASCII_CHAR_MAP_LEN; i++)
+    {
+        uint64_t norm = 0;
+        if (charMap->map[i] != 0)
+        {
+            norm = (charMap->map[i] * (uint64_t)TANS_TABLE_LEN + total / 2) / total;
+            norm = norm == 0 ? 1 : norm;
+            tans->numSymbols++;
+        }
+        tans->normCounts[i] = (uint16_t)norm;
+        sum += (uint32_t)norm;
+        if (charMap->map[i] > charMap->map[largest])
+            largest = i;
+    }
+
+    // Rounding leaves the sum a little off, a surplus goes to the most frequent symbol
+    if (sum < TANS_TABLE_LEN)
+        tans->normCounts[largest] += (uint16_t)(TANS_TABLE_LEN - sum);
+    // and a deficit is taken from the largest counts, where one less costs the least
+    while (sum > TANS_TABLE_LEN)
+    {
+        size_t maxIdx = 0;
+        for (size_t i = 1; i < ASCII_CHAR_MAP_LEN; i++)
+        {
+            if (tans->normCounts[i] > tans->normCounts[maxIdx])
+                maxIdx = i;
+        }
+        tans->normCounts[maxIdx]--;
+        sum--;
+    }
+    return true;
+}
+
+/**
+ * @brief Build the encoding tables from the frequencies of the block
+ *
+ * The states of a symbol are spread over the table with the same step as the decoder so both sides agree on which
+ * state decodes to which symbol.
+ */
+bool tans_buildTable(TansEncoder *tans, const ASCIICharMap *charMap)
+{
+    if (!tans || !charMap || !normalizeCounts(tans, charMap))
+        return false;
+
+    uint8_t spread[TANS_TABLE_LEN];
+    const uint32_t step = (TANS_TABLE_LEN >> 1) + (TANS_TABLE_LEN >> 3) + 3;
+    uint32_t pos = 0;
+    for (size_t i = 0; i < ASCII_CHAR_MAP_LEN; i++)
+    {
+        for (uint32_t n = 0; n < tans->normCounts[i]; n++)
+        {
+            spread[pos] = (uint8_t)i;
+            pos = (pos + step) & (TANS_TABLE_LEN - 1);
+        }
+    }
+
+    uint32_t cumul[ASCII_CHAR_MAP_LEN];
+    uint32_t total = 0;
+    for (size_t i = 0; i < ASCII_CHAR_MAP_LEN; i++)
+    {
+        const uint32_t norm = tans->normCounts[i];
+        cumul[i] = total;
+        if (norm != 0)
+        {
+            // A state x of the symbol leaves nbBits bits behind and moves to the table slot of x >> nbBits
+            const uint32_t maxBitsOut = TANS_TABLE_LOG - highBit(norm - 1);
+            const uint32_t minStatePlus = norm << maxBitsOut;
+            tans->transforms[i].deltaNbBits = (maxBitsOut << 16) - minStatePlus;
+            tans->transforms[i].deltaFindState = (int32_t)total - (int32_t)norm;
+        }
+        total += norm;
+    }
+    for (uint32_t u = 0; u < TANS_TABLE_LEN; u++)
+        tans->stateTable[cumul[spread[u]]++] = (uint16_t)(TANS_TABLE_LEN + u);
+    return true;
+}
+
+/**
+ * @brief Write the table header, the normalized counts and the encoded data
+ *
+ * @param[out] out - Has to hold `TANS_MAX_PAYLOAD_LEN(len)` bytes
+ * @param[out] outLen - The number of bytes written
+ */
+bool tans_encode(TansEncoder *tans, const uint8_t *data, size_t len, uint8_t *out, size_t *outLen)
+{
+    if (!tans || !out || !outLen || tans->numSymbols == 0)
+        return false;
+
+    if (tans->pendingLen < len)
+    {
+        uint32_t *pending = (uint32_t *)realloc(tans->pending, len * sizeof(uint32_t));
+        if (!pending)
+        {
+            fprintf(stderr, "%s: Unable to allocate %zu pending symbols\n", __func__, len);
+            return false;
+        }
+        tans->pending = pending;
+        tans->pendingLen = len;
+    }
+
+    // The decoder runs front to back, so the data is encoded back to front
+    uint32_t state = TANS_TABLE_LEN;
+    for (size_t i = len; i-- > 0;)
+    {
+        const TansSymbolTransform *transform = &tans->transforms[data[i]];
+        if (tans->normCounts[data[i]] == 0)
+            return false;
+        const uint32_t nbBits = (state + transform->deltaNbBits) >> 16;
+        tans->pending[i] = (state & ((1u << nbBits) - 1)) | (nbBits << 16);
+        state = tans->stateTable[(int32_t)(state >> nbBits) + transform->deltaFindState];
+    }
+
+    TansTableHdr hdr = {.tableLog = TANS_TABLE_LOG,
+                        .numSymbols = tans->numSymbols,
+                        .initialState = (uint16_t)(state - TANS_TABLE_LEN)};
+    memcpy(out, &hdr, sizeof(hdr));
+    size_t offset = sizeof(hdr);
+    for (size_t i = 0; i < ASCII_CHAR_MAP_LEN; i++)
+    {
+        if (tans->normCounts[i] == 0)
+            continue;
+        out[offset] = (uint8_t)i;
+        memcpy(out + offset + 1, &tans->normCounts[i], sizeof(uint16_t));
+        offset += TANS_TABLE_ENTRY_LEN;
+    }
+
+    BitWriter bitWriter;
+    bitWriter_init(&bitWriter, out + offset);
+    for (size_t i = 0; i < len; i++)
+        bitWriter_putBits(&bitWriter, tans->pending[i] & 0xffff, (int32_t)(tans->pending[i] >> 16));
+
+    *outLen = offset + bitWriter_flush(&bitWriter);
+    return true;
+}
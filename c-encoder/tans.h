@@ -0,0 +1,65 @@
+//
+// Table based asymmetric numeral system (tANS) entropy coder, an alternative to Huffman codes for blocks whose
+// symbol probabilities are far from powers of two.
+//
+
+#ifndef TANS_H
+#define TANS_H
+
+#include "huffman_encoding.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TANS_TABLE_LOG 11
+#define TANS_TABLE_LEN (1u << TANS_TABLE_LOG)
+
+/**
+ * @brief Starts a tANS payload, followed by `numSymbols` table entries of a uint8_t symbol and its uint16_t
+ *        normalized count, then the encoded data. The normalized counts add up to 1 << `tableLog`.
+ *
+ * The decoder starts at `initialState` and reads the bits of every symbol after decoding it, the encoder writes
+ * them in that order even though it encodes the data back to front.
+ */
+typedef struct
+{
+    uint8_t tableLog;
+    uint8_t reserved;
+    uint16_t numSymbols;
+    uint16_t initialState;
+    uint16_t reserved2;
+} TansTableHdr;
+
+#define TANS_TABLE_ENTRY_LEN (sizeof(uint8_t) + sizeof(uint16_t))
+// Largest payload for `len` bytes of data, no symbol takes more than TANS_TABLE_LOG bits
+#define TANS_MAX_PAYLOAD_LEN(len)                                                                                 \
+    (sizeof(TansTableHdr) + ASCII_CHAR_MAP_LEN * TANS_TABLE_ENTRY_LEN + ((len) * TANS_TABLE_LOG + 7) / 8)
+
+typedef struct
+{
+    int32_t deltaFindState;
+    uint32_t deltaNbBits;
+} TansSymbolTransform;
+
+/**
+ * @brief Reusable tANS encoder state, sized for a single symbol table
+ */
+typedef struct
+{
+    uint16_t normCounts[ASCII_CHAR_MAP_LEN];
+    uint16_t numSymbols;
+    uint16_t stateTable[TANS_TABLE_LEN];
+    TansSymbolTransform transforms[ASCII_CHAR_MAP_LEN];
+    // The bits of every symbol, worked out back to front then written front to back
+    uint32_t *pending;
+    size_t pendingLen;
+} TansEncoder;
+
+void tans_init(TansEncoder *tans);
+void tans_free(TansEncoder *tans);
+
+bool tans_buildTable(TansEncoder *tans, const ASCIICharMap *charMap);
+bool tans_encode(TansEncoder *tans, const uint8_t *data, size_t len, uint8_t *out, size_t *outLen);
+
+#endif // TANS_H
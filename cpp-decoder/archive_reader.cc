@@ -0,0 +1,78 @@
+#include "archive_reader.h"
+#include "huffman_decoder.h"
+
+#include <iostream>
+
+bool isArchive(std::istream &stream)
+{
+    return peekMagic(stream) == ARCHIVE_MAGIC;
+}
+
+/**
+ * @brief Read the central directory of an archive
+ *
+ * Only the header and the directory are read, so this costs the same no matter how large the members are.
+ */
+bool readArchiveDirectory(std::istream &archive, std::vector<ArchiveMember> &members)
+{
+    uint64_t hdr[3] = {};
+    archive.seekg(0, std::ios::end);
+    const uint64_t archiveLen = static_cast<uint64_t>(archive.tellg());
+    archive.seekg(0);
+    if (!archive.read(reinterpret_cast<char *>(hdr), sizeof(hdr)) || hdr[0] != ARCHIVE_MAGIC)
+    {
+        std::cerr << "Not an archive" << std::endl;
+        return false;
+    }
+
+    const uint64_t memberCount = hdr[1];
+    const uint64_t dirOffset = hdr[2];
+    if (dirOffset < ARCHIVE_HDR_LEN || dirOffset > archiveLen ||
+        memberCount > (archiveLen - dirOffset) / ARCHIVE_DIR_ENTRY_LEN)
+    {
+        std::cerr << "Archive directory is out of bounds" << std::endl;
+        return false;
+    }
+
+    archive.seekg(static_cast<std::streamoff>(dirOffset));
+    members.clear();
+    members.reserve(memberCount);
+    for (uint64_t i = 0; i < memberCount; i++)
+    {
+        ArchiveMember member;
+        uint32_t nameLen = 0;
+        archive.read(reinterpret_cast<char *>(&member.offset), sizeof(member.offset));
+        archive.read(reinterpret_cast<char *>(&member.compressedLen), sizeof(member.compressedLen));
+        archive.read(reinterpret_cast<char *>(&member.originalLen), sizeof(member.originalLen));
+        archive.read(reinterpret_cast<char *>(&member.dictOffset), sizeof(member.dictOffset));
+        archive.read(reinterpret_cast<char *>(&member.dictLen), sizeof(member.dictLen));
+        if (!archive.read(reinterpret_cast<char *>(&nameLen), sizeof(nameLen)) || nameLen > ARCHIVE_MAX_NAME_LEN)
+        {
+            std::cerr << "Unable to read archive directory entry " << i << std::endl;
+            return false;
+        }
+        member.name.resize(nameLen);
+        if (!archive.read(member.name.data(), nameLen))
+        {
+            std::cerr << "Unable to read archive member name " << i << std::endl;
+            return false;
+        }
+        if (member.offset > dirOffset || member.compressedLen > dirOffset - member.offset ||
+            member.dictOffset > dirOffset || member.dictLen > dirOffset - member.dictOffset)
+        {
+            std::cerr << "Archive member " << member.name << " is out of bounds" << std::endl;
+            return false;
+        }
+        members.push_back(std::move(member));
+    }
+    return true;
+}
+
+/**
+ * @brief Seek to a member of the archive and decode it. Members are bounded by the directory and have no end block.
+ */
+bool extractMember(std::istream &archive, const ArchiveMember &member, std::ostream &output)
+{
+    archive.seekg(static_cast<std::streamoff>(member.offset));
+    return decodeStream(archive, output, nullptr, member.compressedLen, nullptr, false);
+}
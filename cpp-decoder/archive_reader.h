@@ -0,0 +1,30 @@
+#ifndef ARCHIVE_READER_H
+#define ARCHIVE_READER_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// "HUFARC01" read as a little endian uint64_t, far larger than any uncompressed file length
+static const uint64_t ARCHIVE_MAGIC = 0x3130435241465548;
+static const size_t ARCHIVE_HDR_LEN = 24;
+static const size_t ARCHIVE_DIR_ENTRY_LEN = 44;
+static const uint32_t ARCHIVE_MAX_NAME_LEN = 4096;
+
+struct ArchiveMember
+{
+    std::string name;
+    uint64_t offset;
+    uint64_t compressedLen;
+    uint64_t originalLen;
+    uint64_t dictOffset;
+    uint64_t dictLen;
+};
+
+bool isArchive(std::istream &stream);
+bool readArchiveDirectory(std::istream &archive, std::vector<ArchiveMember> &members);
+bool extractMember(std::istream &archive, const ArchiveMember &member, std::ostream &output);
+
+#endif // ARCHIVE_READER_H
@@ -0,0 +1,310 @@
+#include "block_decoder.h"
+#include "crc32c.h"
+#include "decode_table_cache.h"
+#include "huffman_decoder.h"
+#include "tans_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// The most a payload can be larger than the data of its block, one dictionary per context class
+static const size_t BLOCK_MAX_DICT_OVERHEAD =
+    std::max(CONTEXT_CLASSES * (sizeof(uint64_t) + MAX_DICT_LEN), sizeof(uint64_t) + MAX_STRING_DICT_LEN);
+
+/**
+ * @brief Decode table of the last dictionary of one kind, either built in place or shared from a cache
+ */
+class BlockTable
+{
+  public:
+    explicit BlockTable(DecodeTableCache *cache) : m_Cache(cache), m_Own(), m_Shared(), m_Table(nullptr) {}
+
+    bool load(const char *dictData, size_t dictLen, DictEntryType entryType, const char **error)
+    {
+        if (m_Cache)
+        {
+            m_Shared = m_Cache->get(dictData, dictLen, entryType, error);
+            m_Table = m_Shared.get();
+        }
+        else
+        {
+            m_Table = loadDictionary(dictData, dictLen, m_Own, error, entryType) ? &m_Own : nullptr;
+        }
+        return m_Table != nullptr;
+    }
+
+    bool isLoaded() const { return m_Table != nullptr; }
+    const DecodeTable &table() const { return *m_Table; }
+
+  private:
+    DecodeTableCache                  *m_Cache;
+    DecodeTable                        m_Own;
+    std::shared_ptr<const DecodeTable> m_Shared;
+    const DecodeTable                 *m_Table;
+};
+
+/**
+ * @brief Find the dictionary length and dictionary at `offset` of the payload and move past them
+ */
+static bool readDictionary(const std::vector<char> &payload, size_t &offset, DictEntryType entryType,
+                           const char *&dictData, size_t &dictLen)
+{
+    uint64_t len = 0;
+    if (payload.size() - offset < sizeof(len))
+    {
+        std::cerr << "Huffman block is too short" << std::endl;
+        return false;
+    }
+    std::memcpy(&len, payload.data() + offset, sizeof(len));
+    offset += sizeof(len);
+    const size_t maxDictLen = entryType == DictEntryType::String ? MAX_STRING_DICT_LEN : MAX_DICT_LEN;
+    if (len > maxDictLen || len > payload.size() - offset)
+    {
+        std::cerr << "Huffman block dictionary is out of bounds" << std::endl;
+        return false;
+    }
+
+    dictData = payload.data() + offset;
+    dictLen = static_cast<size_t>(len);
+    offset += dictLen;
+    return true;
+}
+
+static bool readDictionary(const std::vector<char> &payload, size_t &offset, DecodeTable &decodeTable)
+{
+    const char *dictData = nullptr;
+    size_t dictLen = 0;
+    const char *error = nullptr;
+    if (!readDictionary(payload, offset, DictEntryType::Character, dictData, dictLen))
+        return false;
+    if (!loadDictionary(dictData, dictLen, decodeTable, &error))
+    {
+        std::cerr << "Invalid dictionary: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool readDictionary(const std::vector<char> &payload, size_t &offset, BlockTable &blockTable,
+                           DictEntryType entryType)
+{
+    const char *dictData = nullptr;
+    size_t dictLen = 0;
+    const char *error = nullptr;
+    if (!readDictionary(payload, offset, entryType, dictData, dictLen))
+        return false;
+    if (!blockTable.load(dictData, dictLen, entryType, &error))
+    {
+        std::cerr << "Invalid dictionary: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool decodeBlockData(HuffmanDecoder &huffmanDecoder, const std::vector<char> &payload, size_t offset,
+                            std::vector<char> &decoded)
+{
+    if (!huffmanDecoder.decodeByteArray(reinterpret_cast<const std::byte *>(payload.data() + offset),
+                                        payload.size() - offset) ||
+        !huffmanDecoder.finish())
+    {
+        std::cerr << "Unable to decode Huffman block" << std::endl;
+        return false;
+    }
+    decoded = huffmanDecoder.getDecoded();
+    return true;
+}
+
+static bool decodeHuffmanBlock(const BlockHdr &hdr, const std::vector<char> &payload, BlockTable &blockTable,
+                               std::vector<char> &decoded, DictEntryType entryType = DictEntryType::Character)
+{
+    size_t offset = 0;
+    if (!readDictionary(payload, offset, blockTable, entryType))
+        return false;
+
+    HuffmanDecoder huffmanDecoder(hdr.rawLen, blockTable.table());
+    return decodeBlockData(huffmanDecoder, payload, offset, decoded);
+}
+
+static bool decodeReuseBlock(const BlockHdr &hdr, const std::vector<char> &payload, const DecodeTable &decodeTable,
+                             std::vector<char> &decoded)
+{
+    HuffmanDecoder huffmanDecoder(hdr.rawLen, decodeTable);
+    return decodeBlockData(huffmanDecoder, payload, 0, decoded);
+}
+
+static bool decodeContextBlock(const BlockHdr &hdr, const std::vector<char> &payload, ContextTables &contextTables,
+                               std::vector<char> &decoded)
+{
+    size_t offset = 0;
+    for (auto &decodeTable : contextTables)
+    {
+        if (!readDictionary(payload, offset, decodeTable))
+            return false;
+    }
+
+    HuffmanDecoder huffmanDecoder(hdr.rawLen, contextTables);
+    return decodeBlockData(huffmanDecoder, payload, offset, decoded);
+}
+
+static bool decodeTansBlock(const BlockHdr &hdr, const std::vector<char> &payload, TansDecoder &tansDecoder,
+                            std::vector<char> &decoded)
+{
+    size_t offset = 0;
+    const char *error = nullptr;
+    if (!tansDecoder.loadTable(payload.data(), payload.size(), offset, &error) ||
+        !tansDecoder.decode(payload.data() + offset, payload.size() - offset, hdr.rawLen, decoded, &error))
+    {
+        std::cerr << "Unable to decode tANS block: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Decode a block format stream from the current position of `encodedStream`
+ *
+ * Stored blocks are copied to the output as they are, they never go through an entropy decoder. Checksums continue
+ * from block to block, so a block that is missing or out of order fails the check as well.
+ *
+ * @param streamLen - Number of bytes that belong to the stream, decoding also stops at the end of `encodedStream`
+ * @param cache - Shares the decode tables of Huffman and digram dictionaries between streams, may be null
+ * @param requireEnd - The last block has to be an end block, otherwise a file cut off between two blocks would
+ *                     decode without an error
+ */
+bool decodeBlockStream(std::istream &encodedStream, std::ostream &output, uint64_t streamLen, DecodeTableCache *cache,
+                       bool requireEnd)
+{
+    BlockFileHdr fileHdr;
+    if (!encodedStream.read(reinterpret_cast<char *>(&fileHdr), sizeof(fileHdr)) ||
+        fileHdr.magic != BLOCK_FILE_MAGIC)
+    {
+        std::cerr << "Unable to read block file header" << std::endl;
+        return false;
+    }
+    if (fileHdr.blockLen == 0 || fileHdr.blockLen > BLOCK_MAX_LEN)
+    {
+        std::cerr << "Unsupported block length: " << fileHdr.blockLen << std::endl;
+        return false;
+    }
+    if (fileHdr.flags & ~BLOCK_FILE_KNOWN_FLAGS)
+    {
+        std::cerr << "Unsupported block file flags: " << fileHdr.flags << std::endl;
+        return false;
+    }
+    const bool verifyChecksum = fileHdr.flags & BLOCK_FILE_FLAG_CRC32C;
+
+    std::vector<char> payload;
+    std::vector<char> decoded;
+    BlockTable decodeTable(cache);
+    BlockTable digramTable(cache);
+    std::unique_ptr<ContextTables> contextTables;
+    TansDecoder tansDecoder;
+    BlockHdr hdr;
+    uint64_t bytesConsumed = sizeof(fileHdr);
+    uint64_t blockIdx = 0;
+    uint32_t checksum = 0;
+    bool ended = false;
+    while (bytesConsumed < streamLen && encodedStream.read(reinterpret_cast<char *>(&hdr), sizeof(hdr)))
+    {
+        if (hdr.rawLen > fileHdr.blockLen || hdr.payloadLen > fileHdr.blockLen + BLOCK_MAX_DICT_OVERHEAD)
+        {
+            std::cerr << "Block is larger than the block length of the file" << std::endl;
+            return false;
+        }
+
+        bytesConsumed += sizeof(hdr) + hdr.payloadLen;
+        payload.resize(hdr.payloadLen);
+        if (bytesConsumed > streamLen || !encodedStream.read(payload.data(), payload.size()))
+        {
+            std::cerr << "Unable to read block payload" << std::endl;
+            return false;
+        }
+
+        const std::vector<char> *blockData = &decoded;
+        ended = static_cast<BlockType>(hdr.type) == BlockType::End;
+        switch (static_cast<BlockType>(hdr.type))
+        {
+        case BlockType::Stored:
+            if (hdr.payloadLen != hdr.rawLen)
+            {
+                std::cerr << "Stored block has the wrong length" << std::endl;
+                return false;
+            }
+            blockData = &payload;
+            break;
+        case BlockType::Huffman:
+            if (!decodeHuffmanBlock(hdr, payload, decodeTable, decoded))
+                return false;
+            break;
+        case BlockType::HuffmanDigram:
+            if (!decodeHuffmanBlock(hdr, payload, digramTable, decoded, DictEntryType::String))
+                return false;
+            break;
+        case BlockType::HuffmanReuse:
+            if (!decodeTable.isLoaded())
+            {
+                std::cerr << "Block reuses a dictionary before any was given" << std::endl;
+                return false;
+            }
+            if (!decodeReuseBlock(hdr, payload, decodeTable.table(), decoded))
+                return false;
+            break;
+        case BlockType::HuffmanContext:
+            if (!contextTables)
+                contextTables = std::make_unique<ContextTables>();
+            if (!decodeContextBlock(hdr, payload, *contextTables, decoded))
+                return false;
+            break;
+        case BlockType::Tans:
+            if (!decodeTansBlock(hdr, payload, tansDecoder, decoded))
+                return false;
+            break;
+        case BlockType::End:
+            if (hdr.rawLen != 0)
+            {
+                std::cerr << "End block has data" << std::endl;
+                return false;
+            }
+            // Carries the checksum of the block before it, which catches blocks missing from the end of the file
+            if (verifyChecksum && hdr.checksum != checksum)
+            {
+                std::cerr << "Checksum mismatch in the end block after block " << blockIdx << std::endl;
+                return false;
+            }
+            continue;
+        default:
+            std::cerr << "Unknown block type: " << static_cast<int>(hdr.type) << std::endl;
+            return false;
+        }
+
+        // Checked while the decoded block is still in cache, before anything of it is written
+        if (verifyChecksum && crc32c(checksum, blockData->data(), blockData->size()) != hdr.checksum)
+        {
+            std::cerr << "Checksum mismatch in block " << blockIdx << std::endl;
+            return false;
+        }
+        checksum = hdr.checksum;
+        if (!output.write(blockData->data(), blockData->size()))
+        {
+            std::cerr << "Unable to write output" << std::endl;
+            return false;
+        }
+        blockIdx++;
+    }
+
+    if (bytesConsumed < streamLen && encodedStream.gcount() != 0)
+    {
+        std::cerr << "Block header is truncated" << std::endl;
+        return false;
+    }
+    if (requireEnd && !ended)
+    {
+        std::cerr << "File is truncated, it doesn't end with an end block" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef BLOCK_DECODER_H
+#define BLOCK_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+// "HUFBLK01" read as a little endian uint64_t, far larger than any uncompressed file length
+static const uint64_t BLOCK_FILE_MAGIC = 0x31304B4C42465548;
+static const uint32_t BLOCK_MAX_LEN = 16 * 1024 * 1024;
+
+// Every block header carries a CRC32C of the original data of the stream up to the end of the block
+static const uint32_t BLOCK_FILE_FLAG_CRC32C = 0x1;
+static const uint32_t BLOCK_FILE_KNOWN_FLAGS = BLOCK_FILE_FLAG_CRC32C;
+
+enum class BlockType : uint8_t
+{
+    Stored = 0,
+    Huffman = 1,
+    HuffmanContext = 2,
+    Tans = 3,
+    // Encoded with the dictionary of the last Huffman block
+    HuffmanReuse = 4,
+    // Dictionary of string entries with frequent digrams as extra symbols
+    HuffmanDigram = 5,
+    // Lets the encoder append without reading every block, there is nothing to decode
+    End = 6,
+};
+
+struct BlockFileHdr
+{
+    uint64_t magic;
+    uint32_t flags;
+    uint32_t blockLen;
+};
+
+struct BlockHdr
+{
+    uint8_t type;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t rawLen;
+    uint32_t payloadLen;
+    uint32_t checksum;
+};
+
+class DecodeTableCache;
+
+bool decodeBlockStream(std::istream &encodedStream, std::ostream &output, uint64_t streamLen,
+                       DecodeTableCache *cache = nullptr, bool requireEnd = true);
+
+#endif // BLOCK_DECODER_H
@@ -0,0 +1,90 @@
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42 1
+#endif
+
+namespace
+{
+const uint32_t CRC32C_POLY = 0x82F63B78u;
+
+using CrcTable = std::array<std::array<uint32_t, 256>, 8>;
+
+CrcTable buildCrcTable()
+{
+    CrcTable table{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+        table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (size_t slice = 1; slice < table.size(); slice++)
+            table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+    }
+    return table;
+}
+
+uint32_t crc32cSlicing8(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static const CrcTable table = buildCrcTable();
+    while (len >= 8)
+    {
+        // Loaded little endian, the low 4 bytes line up with the crc
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        word ^= crc;
+        crc = table[7][word & 0xff] ^ table[6][(word >> 8) & 0xff] ^ table[5][(word >> 16) & 0xff] ^
+              table[4][(word >> 24) & 0xff] ^ table[3][(word >> 32) & 0xff] ^ table[2][(word >> 40) & 0xff] ^
+              table[1][(word >> 48) & 0xff] ^ table[0][word >> 56];
+        data += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xff];
+    return crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+__attribute__((target("sse4.2"))) uint32_t crc32cSse42(uint32_t crc, const uint8_t *data, size_t len)
+{
+    uint64_t crc64 = crc;
+    while (len >= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        len -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (len--)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#endif
+
+using CrcImpl = uint32_t (*)(uint32_t, const uint8_t *, size_t);
+
+CrcImpl selectCrcImpl()
+{
+#ifdef CRC32C_HAVE_SSE42
+    if (__builtin_cpu_supports("sse4.2"))
+        return crc32cSse42;
+#endif
+    return crc32cSlicing8;
+}
+} // namespace
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+    static const CrcImpl impl = selectCrcImpl();
+    return ~impl(~crc, static_cast<const uint8_t *>(data), len);
+}
@@ -0,0 +1,14 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Update a CRC32C with more data. Start with a crc of 0, `crc32c(0, "123456789", 9)` is 0xe3069283.
+ *
+ * Uses the SSE4.2 crc32 instruction when the CPU has it and slicing-by-8 tables otherwise.
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+#endif // CRC32C_H
@@ -0,0 +1,75 @@
+#include "decode_table_cache.h"
+#include "crc32c.h"
+
+#include <cstring>
+
+DecodeTableCache::DecodeTableCache(size_t capacity)
+    : m_Capacity(capacity > 0 ? capacity : 1), m_Mutex(), m_Entries(), m_Index(), m_Hits(0), m_Misses(0)
+{
+}
+
+/**
+ * @brief The CRC32C of the dictionary with its length and entry type in the upper bits
+ */
+static uint64_t dictionaryKey(const char *dictData, size_t dictLen, DictEntryType entryType)
+{
+    return (static_cast<uint64_t>(dictLen) << 33) | (static_cast<uint64_t>(entryType == DictEntryType::String) << 32) |
+           crc32c(0, dictData, dictLen);
+}
+
+/**
+ * @brief Get the decode table of a dictionary, validating and building it on a miss
+ *
+ * @param[out] error - Set when the dictionary is rejected, see loadDictionary
+ * @returns null when the dictionary is invalid
+ */
+std::shared_ptr<const DecodeTable> DecodeTableCache::get(const char *dictData, size_t dictLen,
+                                                         DictEntryType entryType, const char **error)
+{
+    const uint64_t key = dictionaryKey(dictData, dictLen, entryType);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto found = m_Index.find(key);
+        if (found != m_Index.end() && found->second->dict.size() == dictLen &&
+            std::memcmp(found->second->dict.data(), dictData, dictLen) == 0)
+        {
+            m_Entries.splice(m_Entries.begin(), m_Entries, found->second);
+            m_Hits++;
+            return found->second->table;
+        }
+        m_Misses++;
+    }
+
+    auto table = std::make_shared<DecodeTable>();
+    if (!loadDictionary(dictData, dictLen, *table, error, entryType))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto found = m_Index.find(key);
+    if (found != m_Index.end())
+    {
+        // Built by another thread in the meantime or a collision, either way the newest one is kept
+        m_Entries.erase(found->second);
+        m_Index.erase(found);
+    }
+    m_Entries.push_front(Entry{key, std::vector<char>(dictData, dictData + dictLen), table});
+    m_Index[key] = m_Entries.begin();
+    if (m_Entries.size() > m_Capacity)
+    {
+        m_Index.erase(m_Entries.back().key);
+        m_Entries.pop_back();
+    }
+    return table;
+}
+
+uint64_t DecodeTableCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Hits;
+}
+
+uint64_t DecodeTableCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Misses;
+}
@@ -0,0 +1,48 @@
+#ifndef DECODE_TABLE_CACHE_H
+#define DECODE_TABLE_CACHE_H
+
+#include "dictionary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief LRU cache of decode tables keyed by a hash of their dictionary, shared between threads
+ *
+ * A hit still compares the whole dictionary with the cached one, so a hash collision only costs a rebuild. Tables are
+ * built outside the lock and handed out as shared pointers, an evicted table stays alive while it's being used.
+ */
+class DecodeTableCache
+{
+  public:
+    explicit DecodeTableCache(size_t capacity);
+    DecodeTableCache(const DecodeTableCache &) = delete;
+
+    std::shared_ptr<const DecodeTable> get(const char *dictData, size_t dictLen, DictEntryType entryType,
+                                           const char **error);
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+  private:
+    struct Entry
+    {
+        uint64_t key;
+        std::vector<char> dict;
+        std::shared_ptr<const DecodeTable> table;
+    };
+
+    const size_t                                             m_Capacity;
+    mutable std::mutex                                       m_Mutex;
+    std::list<Entry>                                         m_Entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_Index;
+    uint64_t                                                 m_Hits;
+    uint64_t                                                 m_Misses;
+};
+
+#endif // DECODE_TABLE_CACHE_H
@@ -1,178 +1,113 @@
-#include <array>
-#include <cstdint>
+#include "archive_reader.h"
+#include "huffman_decoder.h"
+
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <unistd.h>
 #include <vector>
 
-static const size_t DICT_ENTRY_LEN = 16;
-static const size_t BYTE_ARRAY_LEN = 1024;
-
-struct BitString
-{
-    uint64_t bitStr;
-    int32_t len;
-};
-
-struct BitStringMapEntry
-{
-    uint64_t bitStr;
-    int32_t len;
-    char character;
-};
-
-using BitStringMap = std::unordered_map<uint64_t, std::vector<BitStringMapEntry>>;
-
-class HuffmanDecoder
+static void printUsage(const char *progName)
 {
-  public:
-    static const int BITS_PER_BYTE = 8;
-    static const size_t CHAR_ARRAY_LEN = 1024;
-    using String = std::array<char, CHAR_ARRAY_LEN>;
-    using StringsVector = std::vector<String>;
-
-    HuffmanDecoder() = delete;
-    HuffmanDecoder(const HuffmanDecoder &) = delete;
-    HuffmanDecoder(uint64_t fileLen, const BitStringMap &bitStringMap);
-
-    bool decodeByteArray(const std::byte *byteArray, size_t byteArrayLen);
-    bool isFinished() const { return m_BytesDecoded == m_UncompressedFileLen; }
-    const StringsVector &getDecodedStrings() const { return m_DecodedStrings; }
-
-  private:
-    bool decodeByte(const std::byte byte);
-
-    uint64_t      m_UncompressedFileLen;
-    uint64_t      m_BytesDecoded;
-    BitString     m_CurrentBitString;
-    BitStringMap  m_BitStringMap;
-    StringsVector m_DecodedStrings;
-};
-
-HuffmanDecoder::HuffmanDecoder(uint64_t fileLen, const BitStringMap &bitStringMap)
-    : m_UncompressedFileLen(fileLen), m_BytesDecoded(0), m_CurrentBitString(), m_BitStringMap(bitStringMap),
-      m_DecodedStrings()
-{
-    m_DecodedStrings.emplace_back();
-    m_DecodedStrings.back().fill(0);
+    std::cerr << "Usage: " << progName << " <encodedFile> [sharedDictFile]" << std::endl;
+    std::cerr << "       " << progName << " [-x member] <archiveFile>" << std::endl;
 }
 
-bool HuffmanDecoder::decodeByte(const std::byte currentByte)
+static bool readSharedDict(const char *dictFilePath, std::vector<char> &dictBuf)
 {
-    if (isFinished())
+    std::ifstream dictFile(dictFilePath, std::ios::binary | std::ios::ate);
+    if (!dictFile)
     {
+        std::cerr << "Unable to open dictionary file" << std::endl;
         return false;
     }
-
-    // Read from MSB to LSB
-    for (int bitIdx = BITS_PER_BYTE - 1; bitIdx >= 0; bitIdx--)
+    const std::streamoff dictLen = dictFile.tellg();
+    if (dictLen < 0 || static_cast<uint64_t>(dictLen) > MAX_DICT_LEN)
     {
-        m_CurrentBitString.bitStr <<= 1;
-        uint64_t currentBit = static_cast<uint64_t>(currentByte) >> bitIdx;
-        m_CurrentBitString.bitStr |= currentBit & 1;
-        m_CurrentBitString.len++;
-        if (m_BitStringMap.find(m_CurrentBitString.bitStr) == m_BitStringMap.end())
-            continue;
-
-        for (const auto &bitStringEntry : m_BitStringMap.at(m_CurrentBitString.bitStr))
-        {
-            if (bitStringEntry.len == m_CurrentBitString.len)
-            {
-                size_t paddingBytes = m_DecodedStrings.size() - 1;
-                size_t decodedByteIdx = (m_BytesDecoded + paddingBytes) % CHAR_ARRAY_LEN;
-                if (decodedByteIdx == (CHAR_ARRAY_LEN - 1))
-                {
-                    m_DecodedStrings.emplace_back();
-                    m_DecodedStrings.back().fill(0);
-                    decodedByteIdx = 0;
-                }
-                m_DecodedStrings.back()[decodedByteIdx] = bitStringEntry.character;
-                m_CurrentBitString.bitStr = 0;
-                m_CurrentBitString.len = 0;
-                m_BytesDecoded++;
-                if (isFinished())
-                    return true;
-            }
-        }
+        std::cerr << "Dictionary file is too large" << std::endl;
+        return false;
+    }
+    dictBuf.resize(static_cast<size_t>(dictLen));
+    dictFile.seekg(0);
+    if (!dictFile.read(dictBuf.data(), dictBuf.size()))
+    {
+        std::cerr << "Unable to read dictionary file" << std::endl;
+        return false;
     }
     return true;
 }
 
-bool HuffmanDecoder::decodeByteArray(const std::byte *byteArray, size_t byteArrayLen)
+// Errors of buffered writes only show up once the stream is flushed
+static int flushOutput(int status)
 {
-    if (m_BytesDecoded == m_UncompressedFileLen)
+    if (status == 0 && !std::cout.flush())
     {
-        return true;
-    }
-    const std::byte *const byteArrayEnd = byteArray + byteArrayLen;
-    for (const std::byte *byteIter = byteArray; byteIter != byteArrayEnd; byteIter++)
-    {
-        if (!decodeByte(*byteIter))
-        {
-            std::cerr << "Failed to decode byte" << std::endl;
-            return false;
-        }
-        if (isFinished())
-            return true;
+        std::cerr << "Unable to write output" << std::endl;
+        return 1;
     }
-
-    return true;
+    return status;
 }
 
-int main(int argc, char **argv)
+static int handleArchive(std::istream &archive, const char *memberName)
 {
-    if (argc < 2)
-    {
-        std::cerr << "Need file to read" << std::endl;
+    std::vector<ArchiveMember> members;
+    if (!readArchiveDirectory(archive, members))
         return 1;
-    }
-    char *encodedFilePath = argv[1];
-    std::ifstream encodedFile(encodedFilePath, std::ios::binary);
-    uint64_t uncompressedFileLen = 0;
-    size_t dictLen = 0;
-    if (!encodedFile.read(reinterpret_cast<char *>(&uncompressedFileLen), sizeof(uncompressedFileLen)))
+
+    if (!memberName)
     {
-        std::cerr << "Unable to read file data" << std::endl;
-        return 1;
+        for (const auto &member : members)
+            std::cout << member.originalLen << "\t" << member.compressedLen << "\t" << member.name << "\n";
+        return 0;
     }
 
-    if (!encodedFile.read(reinterpret_cast<char *>(&dictLen), sizeof(dictLen)))
+    for (const auto &member : members)
     {
-        std::cerr << "Unable to read file data" << std::endl;
-        return 1;
+        if (member.name == memberName)
+            return extractMember(archive, member, std::cout) ? 0 : 1;
     }
+    std::cerr << "No member named " << memberName << " in archive" << std::endl;
+    return 1;
+}
 
-    std::vector<char> dictBuf(dictLen);
-    if (!encodedFile.read(dictBuf.data(), dictBuf.size()))
+int main(int argc, char **argv)
+{
+    const char *memberName = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "x:")) != -1)
     {
-        std::cerr << "Unable to read dictionary of file" << std::endl;
-        return 1;
+        switch (opt)
+        {
+        case 'x':
+            memberName = optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
     }
 
-    BitStringMap huffmanMap(dictLen / DICT_ENTRY_LEN);
-    size_t offset = 0;
-    while (offset < dictLen)
+    if (optind >= argc)
     {
-        BitStringMapEntry *tmp = reinterpret_cast<BitStringMapEntry *>(dictBuf.data() + offset);
-        huffmanMap[tmp->bitStr].push_back(*tmp);
-        offset += DICT_ENTRY_LEN;
+        std::cerr << "Need file to read" << std::endl;
+        printUsage(argv[0]);
+        return 1;
     }
-
-    std::array<char, BYTE_ARRAY_LEN> byteArray;
-    byteArray.fill(0);
-    HuffmanDecoder huffmanDecoder(uncompressedFileLen, huffmanMap);
-    while (encodedFile.read(reinterpret_cast<char *>(byteArray.data()), byteArray.size()) &&
-           !huffmanDecoder.isFinished())
+    char *encodedFilePath = argv[optind];
+    std::ifstream encodedFile(encodedFilePath, std::ios::binary);
+    if (!encodedFile)
     {
-        if (!huffmanDecoder.decodeByteArray(reinterpret_cast<std::byte *>(byteArray.data()), byteArray.size()))
-            return 1;
-
-        byteArray.fill(0);
+        std::cerr << "Unable to open " << encodedFilePath << std::endl;
+        return 1;
     }
 
-    if (encodedFile.eof() && !huffmanDecoder.isFinished())
-        huffmanDecoder.decodeByteArray(reinterpret_cast<std::byte *>(byteArray.data()), byteArray.size());
+    if (isArchive(encodedFile))
+        return flushOutput(handleArchive(encodedFile, memberName));
 
-    for (const auto& decodedString : huffmanDecoder.getDecodedStrings())
-        std::cout << decodedString.data();
+    std::vector<char> sharedDict;
+    if (optind + 1 < argc && !readSharedDict(argv[optind + 1], sharedDict))
+        return 1;
+
+    if (!decodeStream(encodedFile, std::cout, optind + 1 < argc ? &sharedDict : nullptr))
+        return 1;
+    return flushOutput(0);
 }
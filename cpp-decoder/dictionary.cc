@@ -0,0 +1,147 @@
+#include "dictionary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+void DecodeTable::fillLookup(NodeRef ref, int depth, uint32_t prefix)
+{
+    if (isLeaf(ref))
+    {
+        const uint32_t first = prefix << (LOOKUP_BITS - depth);
+        const uint32_t last = (prefix + 1) << (LOOKUP_BITS - depth);
+        for (uint32_t idx = first; idx < last; idx++)
+            m_Lookup[idx] = {ref, static_cast<uint8_t>(depth)};
+        return;
+    }
+
+    // Missing child, the lookup entries stay invalid
+    if (ref == 0)
+        return;
+
+    if (depth == LOOKUP_BITS)
+    {
+        m_Lookup[prefix] = {ref, static_cast<uint8_t>(LOOKUP_BITS)};
+        return;
+    }
+    fillLookup(node(ref).children[0], depth + 1, prefix << 1);
+    fillLookup(node(ref).children[1], depth + 1, (prefix << 1) | 1);
+}
+
+static bool uniqueStrings(const std::vector<DecodeTable::SymbolString> &strings)
+{
+    std::vector<std::string> sorted;
+    sorted.reserve(strings.size());
+    for (const auto &str : strings)
+        sorted.emplace_back(str.bytes.data(), str.len);
+    std::sort(sorted.begin(), sorted.end());
+    return std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+}
+
+/**
+ * @brief Validate a dictionary and build its decoding table
+ *
+ * Each code is inserted into a tree one bit at a time, so the whole check costs O(total code bits):
+ * - the length has to be a whole number of entries and at most `MAX_DICT_ENTRIES` entries, or
+ *   `MAX_STRING_DICT_ENTRIES` for strings
+ * - every code length has to be between 1 and `MAX_CODE_LEN` without bits set above it
+ * - every character or string can only appear once, a string has 1 to `MAX_STRING_ENTRY_LEN` bytes
+ * - the codes have to be prefix free, a code can't end on or pass through another code
+ * - the codes have to be complete (Kraft sum of 1). In a prefix free tree that holds exactly when there is one
+ *   internal node less than there are leaves. A lone code has to be a single bit.
+ *
+ * @param[out] error - Set to a description of the problem when the dictionary is rejected, may be null
+ */
+bool loadDictionary(const char *dictData, size_t dictLen, DecodeTable &table, const char **error,
+                    DictEntryType entryType)
+{
+    auto fail = [error](const char *message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    if (dictLen % DICT_ENTRY_LEN != 0)
+        return fail("Dictionary length is not a multiple of the entry length");
+    const bool isString = entryType == DictEntryType::String;
+    if (dictLen > (isString ? MAX_STRING_DICT_LEN : MAX_DICT_LEN))
+        return fail("Dictionary has too many entries");
+
+    using NodeRef = DecodeTable::NodeRef;
+    std::vector<DecodeTable::Node> &nodes = table.m_Nodes;
+    nodes.assign(1, DecodeTable::Node{});
+    table.m_Lookup.fill({});
+    table.m_MaxCodeLen = 0;
+    table.m_NumSymbols = dictLen / DICT_ENTRY_LEN;
+    table.m_Strings.clear();
+
+    std::array<bool, MAX_DICT_ENTRIES> seen{};
+    for (size_t offset = 0; offset < dictLen; offset += DICT_ENTRY_LEN)
+    {
+        uint64_t bitStr = 0;
+        int32_t len = 0;
+        uint8_t character = 0;
+        std::memcpy(&bitStr, dictData + offset, sizeof(bitStr));
+        std::memcpy(&len, dictData + offset + sizeof(bitStr), sizeof(len));
+        std::memcpy(&character, dictData + offset + sizeof(bitStr) + sizeof(len), sizeof(character));
+
+        if (len < 1 || len > MAX_CODE_LEN)
+            return fail("Code length is out of range");
+        if (bitStr >> len != 0)
+            return fail("Code has bits set above its length");
+
+        NodeRef leafRef = ~static_cast<NodeRef>(character);
+        if (isString)
+        {
+            // The character field is the length of the string, its bytes follow
+            DecodeTable::SymbolString str{character, {}};
+            if (str.len < 1 || str.len > MAX_STRING_ENTRY_LEN)
+                return fail("String length is out of range");
+            std::memcpy(str.bytes.data(), dictData + offset + sizeof(bitStr) + sizeof(len) + 1, str.len);
+            leafRef = ~static_cast<NodeRef>(table.m_Strings.size());
+            table.m_Strings.push_back(str);
+        }
+        else
+        {
+            if (seen[character])
+                return fail("Character appears more than once");
+            seen[character] = true;
+        }
+
+        NodeRef cur = 0;
+        for (int32_t bitIdx = len - 1; bitIdx > 0; bitIdx--)
+        {
+            const size_t bit = (bitStr >> bitIdx) & 1;
+            NodeRef child = nodes[static_cast<size_t>(cur)].children[bit];
+            if (DecodeTable::isLeaf(child))
+                return fail("Dictionary is not prefix free");
+            if (child == 0)
+            {
+                child = static_cast<NodeRef>(nodes.size());
+                nodes[static_cast<size_t>(cur)].children[bit] = child;
+                nodes.emplace_back();
+            }
+            cur = child;
+        }
+
+        NodeRef &leaf = nodes[static_cast<size_t>(cur)].children[bitStr & 1];
+        if (leaf != 0)
+            return fail("Dictionary is not prefix free");
+        leaf = leafRef;
+        if (len > table.m_MaxCodeLen)
+            table.m_MaxCodeLen = len;
+    }
+
+    if (isString && !uniqueStrings(table.m_Strings))
+        return fail("String appears more than once");
+
+    const size_t numSymbols = table.m_NumSymbols;
+    if (numSymbols == 1 && nodes.size() != 1)
+        return fail("A lone code has to be a single bit");
+    if (numSymbols > 1 && nodes.size() != numSymbols - 1)
+        return fail("Dictionary is not a complete prefix code");
+
+    table.fillLookup(nodes[0].children[0], 1, 0);
+    table.fillLookup(nodes[0].children[1], 1, 1);
+    return true;
+}
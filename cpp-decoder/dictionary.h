@@ -0,0 +1,91 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static const size_t DICT_ENTRY_LEN = 16;
+static const size_t MAX_DICT_ENTRIES = 256;
+static const size_t MAX_DICT_LEN = MAX_DICT_ENTRIES * DICT_ENTRY_LEN;
+
+// Dictionaries of string entries have up to 64 digrams next to the single bytes
+static const size_t MAX_STRING_DICT_ENTRIES = MAX_DICT_ENTRIES + 64;
+static const size_t MAX_STRING_DICT_LEN = MAX_STRING_DICT_ENTRIES * DICT_ENTRY_LEN;
+static const size_t MAX_STRING_ENTRY_LEN = 3;
+
+/**
+ * @brief Layout of the 16 byte dictionary entries. Both start with the uint64_t code and int32_t code length, a
+ *        character entry then has the character and a string entry a uint8_t length and up to 3 bytes.
+ */
+enum class DictEntryType
+{
+    Character,
+    String,
+};
+
+// Leaves room for a whole code in the 64 bit buffer of the decoder after refilling it a byte at a time
+static const int32_t MAX_CODE_LEN = 56;
+
+/**
+ * @brief Decoding table built from a validated dictionary
+ *
+ * Codes of up to `LOOKUP_BITS` bits are decoded with a single lookup of the next `LOOKUP_BITS` bits. Longer codes
+ * continue from the tree node stored in the lookup entry one bit at a time.
+ *
+ * A leaf of a character dictionary holds the character itself, a leaf of a string dictionary the index of its
+ * string.
+ */
+class DecodeTable
+{
+  public:
+    static const int LOOKUP_BITS = 10;
+    static const size_t LOOKUP_LEN = size_t(1) << LOOKUP_BITS;
+
+    // A reference to a tree node is its index, a leaf is ~character and 0 (the root) means no child
+    using NodeRef = int32_t;
+
+    struct Node
+    {
+        std::array<NodeRef, 2> children;
+    };
+
+    struct LookupEntry
+    {
+        NodeRef ref;
+        uint8_t len;
+    };
+
+    struct SymbolString
+    {
+        uint8_t len;
+        std::array<char, MAX_STRING_ENTRY_LEN> bytes;
+    };
+
+    static bool isLeaf(NodeRef ref) { return ref < 0; }
+    static char leafCharacter(NodeRef ref) { return static_cast<char>(~ref); }
+    const SymbolString &leafString(NodeRef ref) const { return m_Strings[static_cast<size_t>(~ref)]; }
+    bool hasStrings() const { return !m_Strings.empty(); }
+
+    const LookupEntry &lookup(uint64_t nextBits) const { return m_Lookup[nextBits]; }
+    const Node &node(NodeRef ref) const { return m_Nodes[static_cast<size_t>(ref)]; }
+    int32_t maxCodeLen() const { return m_MaxCodeLen; }
+    size_t numSymbols() const { return m_NumSymbols; }
+
+  private:
+    friend bool loadDictionary(const char *, size_t, DecodeTable &, const char **, DictEntryType);
+
+    void fillLookup(NodeRef ref, int depth, uint32_t prefix);
+
+    std::vector<Node> m_Nodes;
+    std::vector<SymbolString> m_Strings;
+    std::array<LookupEntry, LOOKUP_LEN> m_Lookup{};
+    int32_t m_MaxCodeLen = 0;
+    size_t m_NumSymbols = 0;
+};
+
+bool loadDictionary(const char *dictData, size_t dictLen, DecodeTable &table, const char **error,
+                    DictEntryType entryType = DictEntryType::Character);
+
+#endif // DICTIONARY_H
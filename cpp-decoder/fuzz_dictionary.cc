@@ -0,0 +1,37 @@
+// libFuzzer harness for the dictionary loader. Build with -DHUFFMAN_BUILD_FUZZERS=ON using clang.
+//
+// The first byte picks the entry type, its lowest bit selects string entries. The next two bytes are a little
+// endian count of dictionary entries, which reaches past the largest dictionary of either type so the length
+// checks are fuzzed as well. The rest is decoded with the dictionary when it is accepted.
+
+#include "dictionary.h"
+#include "huffman_decoder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+static const size_t FUZZ_HDR_LEN = 3;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < FUZZ_HDR_LEN)
+        return 0;
+
+    const DictEntryType entryType = (data[0] & 0x1) ? DictEntryType::String : DictEntryType::Character;
+    const size_t numEntries = static_cast<size_t>(data[1]) | static_cast<size_t>(data[2]) << 8;
+    const size_t dictLen = std::min(numEntries * DICT_ENTRY_LEN, size - FUZZ_HDR_LEN);
+    const char *dictData = reinterpret_cast<const char *>(data + FUZZ_HDR_LEN);
+
+    DecodeTable decodeTable;
+    const char *error = nullptr;
+    if (!loadDictionary(dictData, dictLen, decodeTable, &error, entryType))
+        return 0;
+
+    const size_t encodedLen = size - FUZZ_HDR_LEN - dictLen;
+    HuffmanDecoder huffmanDecoder(encodedLen * 8, decodeTable);
+    if (huffmanDecoder.decodeByteArray(reinterpret_cast<const std::byte *>(data + FUZZ_HDR_LEN + dictLen),
+                                       encodedLen))
+        huffmanDecoder.finish();
+    return 0;
+}
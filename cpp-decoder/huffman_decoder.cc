@@ -0,0 +1,241 @@
+#include "huffman_decoder.h"
+#include "block_decoder.h"
+#include "decode_table_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <memory>
+
+/**
+ * @brief Must match huffCtx_contextClass of the encoder
+ */
+static uint8_t contextClass(uint8_t prevChar)
+{
+    enum : uint8_t { Other, Space, Newline, Vowel, Lower, Upper, Digit, Punct };
+    if (prevChar >= 'a' && prevChar <= 'z')
+    {
+        const bool isVowel =
+            prevChar == 'a' || prevChar == 'e' || prevChar == 'i' || prevChar == 'o' || prevChar == 'u';
+        return isVowel ? Vowel : Lower;
+    }
+    if (prevChar >= 'A' && prevChar <= 'Z')
+        return Upper;
+    if (prevChar >= '0' && prevChar <= '9')
+        return Digit;
+    if (prevChar == ' ' || prevChar == '\t')
+        return Space;
+    if (prevChar == '\n' || prevChar == '\r')
+        return Newline;
+    if (prevChar > ' ' && prevChar < 0x7f)
+        return Punct;
+    return Other;
+}
+
+const ContextClassTable &contextClassTable()
+{
+    static const ContextClassTable table = [] {
+        ContextClassTable classes{};
+        for (size_t c = 0; c < classes.size(); c++)
+            classes[c] = contextClass(static_cast<uint8_t>(c));
+        return classes;
+    }();
+    return table;
+}
+
+HuffmanDecoder::HuffmanDecoder(uint64_t fileLen, const DecodeTable &decodeTable)
+    : m_UncompressedFileLen(fileLen), m_BytesDecoded(0), m_BitBuf(0), m_BitCount(0), m_DecodeTables(&decodeTable),
+      m_ContextClasses(nullptr), m_PrevChar(0), m_MaxCodeLen(decodeTable.maxCodeLen()), m_Decoded()
+{
+    m_Decoded.reserve(static_cast<size_t>(std::min<uint64_t>(fileLen, MAX_DECODED_RESERVE_LEN)));
+}
+
+HuffmanDecoder::HuffmanDecoder(uint64_t fileLen, const ContextTables &contextTables)
+    : HuffmanDecoder(fileLen, contextTables[0])
+{
+    m_ContextClasses = contextClassTable().data();
+    for (const auto &table : contextTables)
+        m_MaxCodeLen = std::max(m_MaxCodeLen, table.maxCodeLen());
+}
+
+bool HuffmanDecoder::decodeSymbol()
+{
+    const DecodeTable &decodeTable = m_ContextClasses ? m_DecodeTables[m_ContextClasses[m_PrevChar]]
+                                                      : *m_DecodeTables;
+
+    // The bit buffer is MSB aligned, its top bits are the next bits of the stream
+    const DecodeTable::LookupEntry &entry = decodeTable.lookup(m_BitBuf >> (64 - DecodeTable::LOOKUP_BITS));
+    if (entry.len == 0 || entry.len > m_BitCount)
+        return false;
+
+    DecodeTable::NodeRef ref = entry.ref;
+    m_BitBuf <<= entry.len;
+    m_BitCount -= entry.len;
+    while (!DecodeTable::isLeaf(ref))
+    {
+        if (m_BitCount == 0)
+            return false;
+        ref = decodeTable.node(ref).children[m_BitBuf >> 63];
+        m_BitBuf <<= 1;
+        m_BitCount--;
+        if (ref == 0)
+            return false;
+    }
+
+    if (decodeTable.hasStrings())
+    {
+        const DecodeTable::SymbolString &str = decodeTable.leafString(ref);
+        if (str.len > m_UncompressedFileLen - m_BytesDecoded)
+            return false;
+        // Always appending every byte and dropping the unused ones again avoids a mispredicted branch on the length
+        m_Decoded.insert(m_Decoded.end(), str.bytes.begin(), str.bytes.end());
+        m_Decoded.erase(m_Decoded.end() - (MAX_STRING_ENTRY_LEN - str.len), m_Decoded.end());
+        m_PrevChar = static_cast<uint8_t>(str.bytes[str.len - 1]);
+        m_BytesDecoded += str.len;
+        return true;
+    }
+
+    m_PrevChar = static_cast<uint8_t>(DecodeTable::leafCharacter(ref));
+    m_Decoded.push_back(static_cast<char>(m_PrevChar));
+    m_BytesDecoded++;
+    return true;
+}
+
+bool HuffmanDecoder::decodeByteArray(const std::byte *byteArray, size_t byteArrayLen)
+{
+    const std::byte *byteIter = byteArray;
+    const std::byte *const byteArrayEnd = byteArray + byteArrayLen;
+    while (!isFinished())
+    {
+        // Read from MSB to LSB
+        while (m_BitCount <= 64 - BITS_PER_BYTE && byteIter != byteArrayEnd)
+        {
+            m_BitBuf |= static_cast<uint64_t>(*byteIter++) << (64 - BITS_PER_BYTE - m_BitCount);
+            m_BitCount += BITS_PER_BYTE;
+        }
+        if (m_BitCount < m_MaxCodeLen)
+            return true;
+
+        if (!decodeSymbol())
+        {
+            std::cerr << "Invalid code in encoded data" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decode the symbols left in the bit buffer once all input has been given
+ */
+bool HuffmanDecoder::finish()
+{
+    while (!isFinished())
+    {
+        if (!decodeSymbol())
+        {
+            std::cerr << "Encoded data ended before the whole file was decoded" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Read the first 8 bytes of the stream without moving its read position
+ */
+uint64_t peekMagic(std::istream &stream)
+{
+    const std::streampos start = stream.tellg();
+    uint64_t magic = 0;
+    if (!stream.read(reinterpret_cast<char *>(&magic), sizeof(magic)))
+        magic = 0;
+    stream.clear();
+    stream.seekg(start);
+    return magic;
+}
+
+bool decodeLegacyStream(std::istream &encodedStream, std::ostream &output, const std::vector<char> *sharedDict,
+                        DecodeTableCache *cache)
+{
+    uint64_t uncompressedFileLen = 0;
+    uint64_t dictLen = 0;
+    if (!encodedStream.read(reinterpret_cast<char *>(&uncompressedFileLen), sizeof(uncompressedFileLen)))
+    {
+        std::cerr << "Unable to read file data" << std::endl;
+        return false;
+    }
+
+    if (!encodedStream.read(reinterpret_cast<char *>(&dictLen), sizeof(dictLen)))
+    {
+        std::cerr << "Unable to read file data" << std::endl;
+        return false;
+    }
+
+    // Checked before allocating anything so a bad header can't ask for an arbitrary amount of memory
+    if (dictLen > MAX_DICT_LEN)
+    {
+        std::cerr << "Dictionary length is too large: " << dictLen << std::endl;
+        return false;
+    }
+
+    std::vector<char> dictBuf(dictLen);
+    if (!encodedStream.read(dictBuf.data(), dictBuf.size()))
+    {
+        std::cerr << "Unable to read dictionary of file" << std::endl;
+        return false;
+    }
+
+    // Streams written with a shared dictionary (see huffman_batch.h) don't carry one themselves
+    if (dictLen == 0 && sharedDict)
+        dictBuf = *sharedDict;
+
+    std::shared_ptr<const DecodeTable> cachedTable;
+    DecodeTable ownTable;
+    const char *error = nullptr;
+    if (cache)
+        cachedTable = cache->get(dictBuf.data(), dictBuf.size(), DictEntryType::Character, &error);
+    if (cache ? !cachedTable : !loadDictionary(dictBuf.data(), dictBuf.size(), ownTable, &error))
+    {
+        std::cerr << "Invalid dictionary: " << error << std::endl;
+        return false;
+    }
+
+    std::array<char, BYTE_ARRAY_LEN> byteArray;
+    HuffmanDecoder huffmanDecoder(uncompressedFileLen, cache ? *cachedTable : ownTable);
+    while (!huffmanDecoder.isFinished())
+    {
+        encodedStream.read(byteArray.data(), byteArray.size());
+        const size_t bytesRead = static_cast<size_t>(encodedStream.gcount());
+        if (bytesRead == 0)
+            break;
+
+        if (!huffmanDecoder.decodeByteArray(reinterpret_cast<std::byte *>(byteArray.data()), bytesRead))
+            return false;
+
+        if (!output.write(huffmanDecoder.getDecoded().data(), huffmanDecoder.getDecoded().size()))
+        {
+            std::cerr << "Unable to write output" << std::endl;
+            return false;
+        }
+        huffmanDecoder.clearDecoded();
+    }
+
+    if (!huffmanDecoder.finish())
+        return false;
+    if (!output.write(huffmanDecoder.getDecoded().data(), huffmanDecoder.getDecoded().size()))
+    {
+        std::cerr << "Unable to write output" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool decodeStream(std::istream &encodedStream, std::ostream &output, const std::vector<char> *sharedDict,
+                  uint64_t streamLen, DecodeTableCache *cache, bool requireEnd)
+{
+    if (peekMagic(encodedStream) == BLOCK_FILE_MAGIC)
+        return decodeBlockStream(encodedStream, output, streamLen, cache, requireEnd);
+    return decodeLegacyStream(encodedStream, output, sharedDict, cache);
+}
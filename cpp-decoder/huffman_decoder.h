@@ -0,0 +1,84 @@
+#ifndef HUFFMAN_DECODER_H
+#define HUFFMAN_DECODER_H
+
+#include "dictionary.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+static const size_t BYTE_ARRAY_LEN = 1024;
+static const size_t MAX_DECODED_RESERVE_LEN = 1024 * 1024;
+
+// Number of classes the previous character is put into for order-1 context decoding, see contextClassTable
+static const size_t CONTEXT_CLASSES = 8;
+using ContextClassTable = std::array<uint8_t, 256>;
+
+const ContextClassTable &contextClassTable();
+
+using ContextTables = std::array<DecodeTable, CONTEXT_CLASSES>;
+
+/**
+ * @brief Decodes a bitstream with a `DecodeTable`, which has to outlive the decoder
+ *
+ * With context tables every character is decoded with the table of the context class of the character before it,
+ * the first one follows a 0. A table of string entries emits the whole string of every code.
+ *
+ * Input can be given in as many pieces as needed. A symbol is only decoded once enough bits for the longest code
+ * are buffered, the last few symbols are decoded by `finish` once there is no input left.
+ */
+class HuffmanDecoder
+{
+  public:
+    static const int BITS_PER_BYTE = 8;
+
+    HuffmanDecoder() = delete;
+    HuffmanDecoder(const HuffmanDecoder &) = delete;
+    HuffmanDecoder(uint64_t fileLen, const DecodeTable &decodeTable);
+    HuffmanDecoder(uint64_t fileLen, const ContextTables &contextTables);
+
+    bool decodeByteArray(const std::byte *byteArray, size_t byteArrayLen);
+    bool finish();
+    bool isFinished() const { return m_BytesDecoded == m_UncompressedFileLen; }
+
+    // Decoded bytes that haven't been cleared yet
+    const std::vector<char> &getDecoded() const { return m_Decoded; }
+    void clearDecoded() { m_Decoded.clear(); }
+
+  private:
+    bool decodeSymbol();
+
+    uint64_t           m_UncompressedFileLen;
+    uint64_t           m_BytesDecoded;
+    uint64_t           m_BitBuf;
+    int32_t            m_BitCount;
+    const DecodeTable *m_DecodeTables;
+    const uint8_t     *m_ContextClasses;
+    uint8_t            m_PrevChar;
+    int32_t            m_MaxCodeLen;
+    std::vector<char>  m_Decoded;
+};
+
+uint64_t peekMagic(std::istream &stream);
+
+class DecodeTableCache;
+
+bool decodeLegacyStream(std::istream &encodedStream, std::ostream &output, const std::vector<char> *sharedDict,
+                        DecodeTableCache *cache = nullptr);
+
+/**
+ * @brief Decode one encoded stream from the current position of `encodedStream`, in either the block format or
+ *        the single dictionary format
+ *
+ * @param sharedDict - Dictionary to use when a single dictionary stream doesn't carry its own, may be null
+ * @param streamLen - Number of bytes that belong to the stream
+ * @param cache - Shares decode tables between streams, see DecodeTableCache, may be null
+ * @param requireEnd - A block format stream has to end with an end block, false for archive members which have none
+ */
+bool decodeStream(std::istream &encodedStream, std::ostream &output, const std::vector<char> *sharedDict,
+                  uint64_t streamLen = UINT64_MAX, DecodeTableCache *cache = nullptr, bool requireEnd = true);
+
+#endif // HUFFMAN_DECODER_H
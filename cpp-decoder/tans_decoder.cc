@@ -0,0 +1,129 @@
+#include "tans_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+static int highBit(uint32_t value)
+{
+    return 31 - __builtin_clz(value);
+}
+
+/**
+ * @brief Read and validate the table header and normalized counts at `offset` of the payload and move past them
+ *
+ * The counts have to be of distinct symbols and add up to the table length exactly, anything else can't have come
+ * from the encoder.
+ */
+bool TansDecoder::loadTable(const char *payload, size_t payloadLen, size_t &offset, const char **error)
+{
+    TansTableHdr hdr;
+    if (payloadLen - offset < sizeof(hdr))
+    {
+        *error = "tANS block is too short";
+        return false;
+    }
+    std::memcpy(&hdr, payload + offset, sizeof(hdr));
+    offset += sizeof(hdr);
+    if (hdr.tableLog < TANS_MIN_TABLE_LOG || hdr.tableLog > TANS_MAX_TABLE_LOG)
+    {
+        *error = "Unsupported tANS table log";
+        return false;
+    }
+    const uint32_t tableLen = uint32_t(1) << hdr.tableLog;
+    if (hdr.numSymbols == 0 || hdr.numSymbols > 256 || hdr.initialState >= tableLen)
+    {
+        *error = "Invalid tANS table header";
+        return false;
+    }
+    if (payloadLen - offset < hdr.numSymbols * TANS_TABLE_ENTRY_LEN)
+    {
+        *error = "tANS table is out of bounds";
+        return false;
+    }
+
+    std::array<uint16_t, 256> normCounts{};
+    uint32_t total = 0;
+    for (size_t i = 0; i < hdr.numSymbols; i++)
+    {
+        const uint8_t symbol = static_cast<uint8_t>(payload[offset]);
+        uint16_t count = 0;
+        std::memcpy(&count, payload + offset + 1, sizeof(count));
+        offset += TANS_TABLE_ENTRY_LEN;
+        if (count == 0 || normCounts[symbol] != 0)
+        {
+            *error = "Invalid tANS symbol count";
+            return false;
+        }
+        normCounts[symbol] = count;
+        total += count;
+    }
+    if (total != tableLen)
+    {
+        *error = "tANS symbol counts don't add up to the table length";
+        return false;
+    }
+
+    // Same spread as the encoder, the step is odd so every state is visited once
+    m_Table.assign(tableLen, Entry{});
+    const uint32_t step = (tableLen >> 1) + (tableLen >> 3) + 3;
+    uint32_t pos = 0;
+    for (size_t symbol = 0; symbol < normCounts.size(); symbol++)
+    {
+        for (uint32_t n = 0; n < normCounts[symbol]; n++)
+        {
+            m_Table[pos].symbol = static_cast<uint8_t>(symbol);
+            pos = (pos + step) & (tableLen - 1);
+        }
+    }
+
+    std::array<uint32_t, 256> symbolNext;
+    std::copy(normCounts.begin(), normCounts.end(), symbolNext.begin());
+    for (auto &entry : m_Table)
+    {
+        const uint32_t nextState = symbolNext[entry.symbol]++;
+        entry.nbBits = static_cast<uint8_t>(hdr.tableLog - highBit(nextState));
+        entry.newState = static_cast<uint16_t>((nextState << entry.nbBits) - tableLen);
+    }
+    m_InitialState = hdr.initialState;
+    return true;
+}
+
+/**
+ * @brief Decode `rawLen` symbols from the encoded data that follows the table
+ */
+bool TansDecoder::decode(const char *data, size_t len, uint64_t rawLen, std::vector<char> &decoded,
+                         const char **error) const
+{
+    decoded.resize(rawLen);
+
+    // MSB aligned like the Huffman decoder, the top bits are the next bits of the stream
+    uint64_t bitBuf = 0;
+    int bitCount = 0;
+    size_t byteIdx = 0;
+    uint32_t state = m_InitialState;
+    for (uint64_t i = 0; i < rawLen; i++)
+    {
+        const Entry &entry = m_Table[state];
+        decoded[i] = static_cast<char>(entry.symbol);
+
+        while (bitCount <= 56 && byteIdx != len)
+        {
+            bitBuf |= static_cast<uint64_t>(static_cast<uint8_t>(data[byteIdx++])) << (56 - bitCount);
+            bitCount += 8;
+        }
+        if (entry.nbBits > bitCount)
+        {
+            *error = "tANS data ended before the whole block was decoded";
+            return false;
+        }
+        state = entry.newState;
+        if (entry.nbBits != 0)
+        {
+            state += static_cast<uint32_t>(bitBuf >> (64 - entry.nbBits));
+            bitBuf <<= entry.nbBits;
+            bitCount -= entry.nbBits;
+        }
+    }
+    return true;
+}
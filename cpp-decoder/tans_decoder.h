@@ -0,0 +1,47 @@
+#ifndef TANS_DECODER_H
+#define TANS_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Smaller tables don't spread their states with the step the encoder uses
+static const int TANS_MIN_TABLE_LOG = 5;
+static const int TANS_MAX_TABLE_LOG = 12;
+static const size_t TANS_TABLE_ENTRY_LEN = sizeof(uint8_t) + sizeof(uint16_t);
+
+struct TansTableHdr
+{
+    uint8_t tableLog;
+    uint8_t reserved;
+    uint16_t numSymbols;
+    uint16_t initialState;
+    uint16_t reserved2;
+};
+
+/**
+ * @brief Decodes tANS payloads (see tans.h of the encoder), a table is loaded per block
+ *
+ * Every state is one table entry, decoding a symbol is a lookup of the state followed by reading the bits of the
+ * next state.
+ */
+class TansDecoder
+{
+  public:
+    struct Entry
+    {
+        uint16_t newState;
+        uint8_t symbol;
+        uint8_t nbBits;
+    };
+
+    bool loadTable(const char *payload, size_t payloadLen, size_t &offset, const char **error);
+    bool decode(const char *data, size_t len, uint64_t rawLen, std::vector<char> &decoded,
+                const char **error) const;
+
+  private:
+    std::vector<Entry> m_Table;
+    uint32_t m_InitialState = 0;
+};
+
+#endif // TANS_DECODER_H
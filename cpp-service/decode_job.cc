@@ -0,0 +1,134 @@
+#include "decode_job.h"
+#include "decode_table_cache.h"
+#include "huffman_decoder.h"
+
+#include <array>
+#include <cerrno>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <unistd.h>
+
+static const size_t OUTPUT_BUF_LEN = 64 * 1024;
+
+/**
+ * @brief Read only stream buffer over memory the caller owns, seekable for peekMagic
+ */
+class MemoryStreamBuf : public std::streambuf
+{
+  public:
+    MemoryStreamBuf(const char *data, size_t len)
+    {
+        char *begin = const_cast<char *>(data);
+        setg(begin, begin, begin + len);
+    }
+
+  protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if (!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+        off_type base = 0;
+        if (dir == std::ios_base::cur)
+            base = gptr() - eback();
+        else if (dir == std::ios_base::end)
+            base = egptr() - eback();
+        return seekpos(pos_type(base + off), which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        const off_type offset = pos;
+        if (!(which & std::ios_base::in) || offset < 0 || offset > egptr() - eback())
+            return pos_type(off_type(-1));
+        setg(eback(), eback() + offset, egptr());
+        return pos;
+    }
+};
+
+/**
+ * @brief Buffered stream buffer writing to an fd it doesn't own, keeps the errno of the first failed write
+ */
+class FdStreamBuf : public std::streambuf
+{
+  public:
+    explicit FdStreamBuf(int fd) : m_Fd(fd), m_Error(0), m_BytesWritten(0), m_Buf()
+    {
+        setp(m_Buf.data(), m_Buf.data() + m_Buf.size());
+    }
+
+    int error() const { return m_Error; }
+    uint64_t bytesWritten() const { return m_BytesWritten; }
+
+  protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!flushBuf())
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *data, std::streamsize len) override
+    {
+        // Whole decoded blocks go straight to the fd instead of through the buffer
+        if (len < static_cast<std::streamsize>(m_Buf.size()))
+            return std::streambuf::xsputn(data, len);
+        if (!flushBuf() || !writeAll(data, static_cast<size_t>(len)))
+            return 0;
+        return len;
+    }
+
+    int sync() override { return flushBuf() ? 0 : -1; }
+
+  private:
+    bool flushBuf()
+    {
+        const bool success = writeAll(pbase(), static_cast<size_t>(pptr() - pbase()));
+        setp(m_Buf.data(), m_Buf.data() + m_Buf.size());
+        return success;
+    }
+
+    bool writeAll(const char *data, size_t len)
+    {
+        while (len > 0 && m_Error == 0)
+        {
+            const ssize_t written = write(m_Fd, data, len);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0)
+            {
+                m_Error = errno;
+                break;
+            }
+            data += written;
+            len -= static_cast<size_t>(written);
+            m_BytesWritten += static_cast<uint64_t>(written);
+        }
+        return m_Error == 0;
+    }
+
+    int                              m_Fd;
+    int                              m_Error;
+    uint64_t                         m_BytesWritten;
+    std::array<char, OUTPUT_BUF_LEN> m_Buf;
+};
+
+int runDecodeJob(const InputBuffer &input, int outputFd, DecodeTableCache &cache, uint64_t &bytesOut)
+{
+    MemoryStreamBuf inputBuf(input.data(), input.size());
+    std::istream encodedStream(&inputBuf);
+    FdStreamBuf outputBuf(outputFd);
+    std::ostream output(&outputBuf);
+
+    const bool success = decodeStream(encodedStream, output, nullptr, input.size(), &cache);
+    output.flush();
+    bytesOut = outputBuf.bytesWritten();
+    if (outputBuf.error() != 0)
+        return outputBuf.error();
+    return success ? 0 : EINVAL;
+}
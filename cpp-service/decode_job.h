@@ -0,0 +1,19 @@
+#ifndef DECODE_JOB_H
+#define DECODE_JOB_H
+
+#include "input_buffer.h"
+
+#include <cstdint>
+
+class DecodeTableCache;
+
+/**
+ * @brief Decode the input of a request into `outputFd`, a single dictionary stream or a block format stream
+ *
+ * @param cache - Decode tables shared by all requests
+ * @param[out] bytesOut - Number of decoded bytes written
+ * @returns 0 or an errno value, EINVAL when the input doesn't decode
+ */
+int runDecodeJob(const InputBuffer &input, int outputFd, DecodeTableCache &cache, uint64_t &bytesOut);
+
+#endif // DECODE_JOB_H
@@ -0,0 +1,54 @@
+#include "encode_job.h"
+
+extern "C"
+{
+#include "block_format.h"
+}
+
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+int runEncodeJob(const HuffdRequest &request, const InputBuffer &input, int outputFd, uint64_t &bytesOut)
+{
+    if (request.backend > static_cast<uint8_t>(HuffdBackend::Auto) || (request.flags & ~HUFFD_KNOWN_FLAGS))
+        return EINVAL;
+
+    BlockEncoderOptions options;
+    options.fileFlags = (request.flags & HUFFD_FLAG_CRC32C) ? BLOCK_FILE_FLAG_CRC32C : 0;
+    options.backend = static_cast<BlockBackend>(request.backend);
+    options.useContexts = request.flags & HUFFD_FLAG_CONTEXTS;
+    options.useDigrams = request.flags & HUFFD_FLAG_DIGRAMS;
+    options.sampleDict = request.flags & HUFFD_FLAG_SAMPLED;
+    options.reuseDict = false;
+    if (!blockEncoder_validOptions(&options))
+        return EINVAL;
+
+    // The output fd belongs to the request, the stream gets its own copy to close
+    const int streamFd = dup(outputFd);
+    FILE *outputFile = streamFd >= 0 ? fdopen(streamFd, "wb") : nullptr;
+    if (!outputFile)
+    {
+        const int status = errno;
+        if (streamFd >= 0)
+            close(streamFd);
+        return status;
+    }
+
+    BlockEncoder enc;
+    if (!blockEncoder_init(&enc, &options))
+    {
+        blockEncoder_free(&enc);
+        fclose(outputFile);
+        return ENOMEM;
+    }
+    int status = 0;
+    if (!blockEncoder_encodeBufferToFile(&enc, reinterpret_cast<const uint8_t *>(input.data()), input.size(),
+                                         outputFile))
+        status = EIO;
+    bytesOut = enc.stats.bytesOut;
+    blockEncoder_free(&enc);
+    if (fclose(outputFile) != 0 && status == 0)
+        status = EIO;
+    return status;
+}
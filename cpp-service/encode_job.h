@@ -0,0 +1,19 @@
+#ifndef ENCODE_JOB_H
+#define ENCODE_JOB_H
+
+#include "input_buffer.h"
+#include "protocol.h"
+
+#include <cstdint>
+
+/**
+ * @brief Encode the input of a request into `outputFd` in the block format, like `encoding` with the request flags
+ *
+ * Kept apart from the decoder since the encoder headers define the block format names the decoder headers do.
+ *
+ * @param[out] bytesOut - Length of the encoded stream
+ * @returns 0 or an errno value
+ */
+int runEncodeJob(const HuffdRequest &request, const InputBuffer &input, int outputFd, uint64_t &bytesOut);
+
+#endif // ENCODE_JOB_H
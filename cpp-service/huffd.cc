@@ -0,0 +1,391 @@
+#include "decode_job.h"
+#include "decode_table_cache.h"
+#include "encode_job.h"
+#include "input_buffer.h"
+#include "protocol.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const size_t DEFAULT_CACHE_ENTRIES = 64;
+static const size_t DEFAULT_MAX_INPUT_MIB = 1024;
+static const int LISTEN_BACKLOG = 128;
+
+static int s_StopPipe[2] = {-1, -1};
+
+static void handleStopSignal(int)
+{
+    const char byte = 0;
+    (void)!write(s_StopPipe[1], &byte, sizeof(byte));
+}
+
+/**
+ * @brief Hands connections with a request waiting to the workers, one request at a time
+ *
+ * Idle connections are polled by the main thread. A connection leaves the poll set while a worker serves its
+ * request and goes back once the response is sent, so idle and persistent clients don't hold on to a worker.
+ */
+class Dispatcher
+{
+  public:
+    Dispatcher() : m_WakePipe{-1, -1} {}
+    Dispatcher(const Dispatcher &) = delete;
+
+    ~Dispatcher()
+    {
+        for (int fd : m_WakePipe)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    bool init() { return pipe2(m_WakePipe, O_CLOEXEC | O_NONBLOCK) == 0; }
+
+    // Returns -1 once the dispatcher is stopped
+    int pop()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Cond.wait(lock, [this] { return m_Stopped || !m_Ready.empty(); });
+        if (m_Stopped)
+            return -1;
+        const int conn = m_Ready.front();
+        m_Ready.pop_front();
+        return conn;
+    }
+
+    // Give a served connection back to be polled for its next request
+    void release(int conn)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Stopped)
+        {
+            close(conn);
+            return;
+        }
+        m_Released.push_back(conn);
+        // A full pipe already wakes the poll
+        const char byte = 0;
+        (void)!write(m_WakePipe[1], &byte, sizeof(byte));
+    }
+
+    /**
+     * @brief Accept connections and dispatch the ones with a request until `stopFd` becomes readable
+     */
+    void run(int listenSock, int stopFd)
+    {
+        std::vector<int> idle;
+        std::vector<pollfd> fds;
+        for (;;)
+        {
+            fds.assign({{listenSock, POLLIN, 0}, {stopFd, POLLIN, 0}, {m_WakePipe[0], POLLIN, 0}});
+            for (int conn : idle)
+                fds.push_back({conn, POLLIN, 0});
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "Unable to poll (errno: " << errno << ")" << std::endl;
+                break;
+            }
+            if (fds[1].revents)
+                break;
+
+            // End of file and errors are dispatched as well, the worker sees them and closes the connection
+            std::vector<int> stillIdle;
+            for (size_t i = 3; i < fds.size(); i++)
+            {
+                if (fds[i].revents)
+                    push(fds[i].fd);
+                else
+                    stillIdle.push_back(fds[i].fd);
+            }
+            idle.swap(stillIdle);
+
+            if (fds[2].revents & POLLIN)
+            {
+                char drain[64];
+                while (read(m_WakePipe[0], drain, sizeof(drain)) > 0)
+                    ;
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                idle.insert(idle.end(), m_Released.begin(), m_Released.end());
+                m_Released.clear();
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                const int conn = accept4(listenSock, nullptr, nullptr, SOCK_CLOEXEC);
+                if (conn >= 0)
+                    idle.push_back(conn);
+                else if (errno != EINTR && errno != ECONNABORTED)
+                    std::cerr << "Unable to accept (errno: " << errno << ")" << std::endl;
+            }
+        }
+        for (int conn : idle)
+            close(conn);
+    }
+
+    // Workers finish the request they are on, connections that aren't being served are closed
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopped = true;
+        for (int conn : m_Ready)
+            close(conn);
+        for (int conn : m_Released)
+            close(conn);
+        m_Ready.clear();
+        m_Released.clear();
+        m_Cond.notify_all();
+    }
+
+  private:
+    void push(int conn)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Ready.push_back(conn);
+        m_Cond.notify_one();
+    }
+
+    int m_WakePipe[2];
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::deque<int> m_Ready;
+    std::vector<int> m_Released;
+    bool m_Stopped = false;
+};
+
+struct ServiceStats
+{
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+};
+
+/**
+ * @brief Run one request, a request that runs out of memory fails with ENOMEM instead of taking the service down
+ */
+static HuffdResponse handleRequest(const HuffdRequest &request, int inputFd, int outputFd, size_t maxInputLen,
+                                   DecodeTableCache &cache)
+{
+    HuffdResponse response{HUFFD_MAGIC, 0, 0, 0};
+    try
+    {
+        InputBuffer input;
+        response.status = input.load(inputFd, maxInputLen);
+        if (response.status != 0)
+            return response;
+        response.bytesIn = input.size();
+
+        switch (static_cast<HuffdOp>(request.op))
+        {
+        case HuffdOp::Encode:
+            response.status = runEncodeJob(request, input, outputFd, response.bytesOut);
+            break;
+        case HuffdOp::Decode:
+            response.status = runDecodeJob(input, outputFd, cache, response.bytesOut);
+            break;
+        default:
+            response.status = EINVAL;
+            break;
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        response.status = ENOMEM;
+    }
+    return response;
+}
+
+/**
+ * @brief Serve one request of every connection the dispatcher hands out
+ */
+static void serviceWorker(Dispatcher &dispatcher, size_t maxInputLen, DecodeTableCache &cache, ServiceStats &stats)
+{
+    int conn;
+    while ((conn = dispatcher.pop()) >= 0)
+    {
+        HuffdRequest request;
+        int inputFd = -1;
+        int outputFd = -1;
+        bool eof = false;
+        if (!recvRequest(conn, request, inputFd, outputFd, eof))
+        {
+            close(conn);
+            continue;
+        }
+
+        const HuffdResponse response = handleRequest(request, inputFd, outputFd, maxInputLen, cache);
+        close(inputFd);
+        close(outputFd);
+
+        stats.requests++;
+        stats.failed += response.status != 0;
+        stats.bytesIn += response.bytesIn;
+        stats.bytesOut += response.bytesOut;
+        if (sendResponse(conn, response))
+            dispatcher.release(conn);
+        else
+            close(conn);
+    }
+}
+
+// Removes a socket left behind by a daemon that is gone. Anything else at the path, or a socket something still
+// listens on, is left alone and errno is set to EADDRINUSE
+static bool removeStaleSocket(const sockaddr_un &addr)
+{
+    struct stat st;
+    if (lstat(addr.sun_path, &st) != 0)
+        return errno == ENOENT;
+    if (!S_ISSOCK(st.st_mode))
+    {
+        errno = EADDRINUSE;
+        return false;
+    }
+
+    const int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+        return false;
+    const bool refused = connect(probe, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 &&
+                         errno == ECONNREFUSED;
+    close(probe);
+    if (!refused)
+    {
+        errno = EADDRINUSE;
+        return false;
+    }
+    return unlink(addr.sun_path) == 0 || errno == ENOENT;
+}
+
+static int listenService(const char *socketPath, sockaddr_un &addr)
+{
+    addr = sockaddr_un{};
+    addr.sun_family = AF_UNIX;
+    if (std::strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        std::cerr << "Socket path is too long: " << socketPath << std::endl;
+        return -1;
+    }
+    std::strcpy(addr.sun_path, socketPath);
+
+    const int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+    {
+        std::cerr << "Unable to create socket (errno: " << errno << ")" << std::endl;
+        return -1;
+    }
+    if (!removeStaleSocket(addr) || bind(sock, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(sock, LISTEN_BACKLOG) != 0)
+    {
+        std::cerr << "Unable to listen on " << socketPath << " (errno: " << errno << ")" << std::endl;
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void printUsage(const char *progName)
+{
+    std::cerr << "Usage: " << progName << " [-j threads] [-t tables] [-m maxInputMiB] <socketPath>" << std::endl;
+    std::cerr << "       -j number of requests served at once, defaults to the number of CPUs" << std::endl;
+    std::cerr << "       -t number of decode tables kept in the cache, defaults to " << DEFAULT_CACHE_ENTRIES
+              << std::endl;
+    std::cerr << "       -m longest input a request can have, larger ones fail with EFBIG, defaults to "
+              << DEFAULT_MAX_INPUT_MIB << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t numThreads = std::thread::hardware_concurrency();
+    size_t cacheEntries = DEFAULT_CACHE_ENTRIES;
+    size_t maxInputMiB = DEFAULT_MAX_INPUT_MIB;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:t:m:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            numThreads = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 't':
+            cacheEntries = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'm':
+            maxInputMiB = std::strtoul(optarg, nullptr, 10);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (numThreads == 0)
+        numThreads = 1;
+
+    const char *socketPath = argv[optind];
+    sockaddr_un addr;
+    const int listenSock = listenService(socketPath, addr);
+    if (listenSock < 0)
+        return 1;
+
+    if (pipe2(s_StopPipe, O_CLOEXEC) != 0)
+    {
+        std::cerr << "Unable to create pipe (errno: " << errno << ")" << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+    // Clients that go away mid request show up as failed writes instead
+    std::signal(SIGPIPE, SIG_IGN);
+
+    DecodeTableCache cache(cacheEntries);
+    Dispatcher dispatcher;
+    ServiceStats stats;
+    if (!dispatcher.init())
+    {
+        std::cerr << "Unable to create pipe (errno: " << errno << ")" << std::endl;
+        return 1;
+    }
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < numThreads; i++)
+        workers.emplace_back(serviceWorker, std::ref(dispatcher), maxInputMiB * 1024 * 1024, std::ref(cache),
+                             std::ref(stats));
+
+    std::cerr << "Listening on " << socketPath << " with " << numThreads << " workers" << std::endl;
+    dispatcher.run(listenSock, s_StopPipe[0]);
+
+    close(listenSock);
+    // Once closed our socket refuses connections, a path replaced in the meantime is not ours to remove
+    removeStaleSocket(addr);
+    dispatcher.stop();
+    for (auto &worker : workers)
+        worker.join();
+
+    std::cerr << "Requests       : " << stats.requests << std::endl;
+    std::cerr << "Failed         : " << stats.failed << std::endl;
+    std::cerr << "Bytes In       : " << stats.bytesIn << std::endl;
+    std::cerr << "Bytes Out      : " << stats.bytesOut << std::endl;
+    std::cerr << "Table Hits     : " << cache.hits() << std::endl;
+    std::cerr << "Table Misses   : " << cache.misses() << std::endl;
+    return 0;
+}
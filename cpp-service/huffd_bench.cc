@@ -0,0 +1,186 @@
+#include "protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig
+{
+    const char *socketPath;
+    const char *filePath;
+    const char *spawnPath;
+    HuffdOp op;
+    size_t numClients;
+    size_t numRequests;
+};
+
+struct ClientResult
+{
+    std::vector<double> latenciesUs;
+    uint64_t bytesOut = 0;
+    size_t failed = 0;
+};
+
+static double elapsedUs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Send `numRequests` requests one after another on a single connection, output goes to /dev/null
+ */
+static void serviceClient(const BenchConfig &config, ClientResult &result)
+{
+    const int sock = connectService(config.socketPath);
+    const int outputFd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (sock < 0 || outputFd < 0)
+    {
+        result.failed = config.numRequests;
+        return;
+    }
+
+    const HuffdRequest request{HUFFD_MAGIC, static_cast<uint8_t>(config.op),
+                               static_cast<uint8_t>(HuffdBackend::Huffman), 0};
+    for (size_t i = 0; i < config.numRequests; i++)
+    {
+        const Clock::time_point start = Clock::now();
+        const int inputFd = open(config.filePath, O_RDONLY | O_CLOEXEC);
+        HuffdResponse response;
+        const bool success = inputFd >= 0 && sendRequest(sock, request, inputFd, outputFd) &&
+                             recvResponse(sock, response) && response.status == 0;
+        if (inputFd >= 0)
+            close(inputFd);
+        result.latenciesUs.push_back(elapsedUs(start));
+        if (success)
+            result.bytesOut += response.bytesOut;
+        else
+            result.failed++;
+    }
+    close(outputFd);
+    close(sock);
+}
+
+/**
+ * @brief Run the command line tool once per request instead, the way the service replaces
+ */
+static void spawnClient(const BenchConfig &config, ClientResult &result)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    std::vector<char *> args = {const_cast<char *>(config.spawnPath), const_cast<char *>(config.filePath)};
+    if (config.op == HuffdOp::Encode)
+        args.push_back(const_cast<char *>("/dev/null"));
+    args.push_back(nullptr);
+
+    for (size_t i = 0; i < config.numRequests; i++)
+    {
+        const Clock::time_point start = Clock::now();
+        pid_t pid;
+        int status = 0;
+        const bool success = posix_spawn(&pid, config.spawnPath, &actions, nullptr, args.data(), environ) == 0 &&
+                             waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        result.latenciesUs.push_back(elapsedUs(start));
+        if (!success)
+            result.failed++;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+}
+
+static void runClients(const char *name, const BenchConfig &config,
+                       void (*client)(const BenchConfig &, ClientResult &))
+{
+    std::vector<ClientResult> results(config.numClients);
+    std::vector<std::thread> threads;
+    const Clock::time_point start = Clock::now();
+    for (auto &result : results)
+        threads.emplace_back(client, std::cref(config), std::ref(result));
+    for (auto &thread : threads)
+        thread.join();
+    const double totalUs = elapsedUs(start);
+
+    std::vector<double> latenciesUs;
+    uint64_t bytesOut = 0;
+    size_t failed = 0;
+    for (const auto &result : results)
+    {
+        latenciesUs.insert(latenciesUs.end(), result.latenciesUs.begin(), result.latenciesUs.end());
+        bytesOut += result.bytesOut;
+        failed += result.failed;
+    }
+    if (latenciesUs.empty())
+        return;
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+
+    std::cout << name << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  Requests   : " << latenciesUs.size() << " (" << failed << " failed)\n";
+    std::cout << "  Requests/s : " << latenciesUs.size() / (totalUs / 1e6) << "\n";
+    std::cout << "  p50 (us)   : " << latenciesUs[latenciesUs.size() / 2] << "\n";
+    std::cout << "  p99 (us)   : " << latenciesUs[latenciesUs.size() * 99 / 100] << "\n";
+    if (bytesOut != 0)
+        std::cout << "  MB/s out   : " << bytesOut / totalUs << "\n";
+}
+
+static void printUsage(const char *progName)
+{
+    std::cerr << "Usage: " << progName << " [-E] [-n clients] [-r requests] [-s toolPath] <socketPath> <file>"
+              << std::endl;
+    std::cerr << "       decodes <file> over and over, -E encodes it instead" << std::endl;
+    std::cerr << "       -s also runs toolPath (decoding, or encoding with -E) once per request to compare"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config{nullptr, nullptr, nullptr, HuffdOp::Decode, 4, 1000};
+    int opt;
+    while ((opt = getopt(argc, argv, "En:r:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'E':
+            config.op = HuffdOp::Encode;
+            break;
+        case 'n':
+            config.numClients = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'r':
+            config.numRequests = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 's':
+            config.spawnPath = optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind != 2 || config.numClients == 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    config.socketPath = argv[optind];
+    config.filePath = argv[optind + 1];
+
+    runClients("huffd", config, serviceClient);
+    if (config.spawnPath)
+        runClients(config.spawnPath, config, spawnClient);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "protocol.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+static void printUsage(const char *progName)
+{
+    std::cerr << "Usage: " << progName << " [-c] [-C] [-d] [-e backend] [-f] <socketPath> encode|decode <inputFile> "
+              << "<outputFile>" << std::endl;
+    std::cerr << "       the encode options are the ones of encoding" << std::endl;
+}
+
+static bool parseBackend(const char *name, uint8_t &backend)
+{
+    if (std::strcmp(name, "huffman") == 0)
+        backend = static_cast<uint8_t>(HuffdBackend::Huffman);
+    else if (std::strcmp(name, "tans") == 0)
+        backend = static_cast<uint8_t>(HuffdBackend::Tans);
+    else if (std::strcmp(name, "auto") == 0)
+        backend = static_cast<uint8_t>(HuffdBackend::Auto);
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    HuffdRequest request{HUFFD_MAGIC, 0, static_cast<uint8_t>(HuffdBackend::Huffman), 0};
+    int opt;
+    while ((opt = getopt(argc, argv, "cCde:f")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            request.flags |= HUFFD_FLAG_CRC32C;
+            break;
+        case 'C':
+            request.flags |= HUFFD_FLAG_CONTEXTS;
+            break;
+        case 'd':
+            request.flags |= HUFFD_FLAG_DIGRAMS;
+            break;
+        case 'e':
+            if (!parseBackend(optarg, request.backend))
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'f':
+            request.flags |= HUFFD_FLAG_SAMPLED;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind != 4)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (std::strcmp(argv[optind + 1], "encode") == 0)
+        request.op = static_cast<uint8_t>(HuffdOp::Encode);
+    else if (std::strcmp(argv[optind + 1], "decode") == 0)
+        request.op = static_cast<uint8_t>(HuffdOp::Decode);
+    else
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const char *inputPath = argv[optind + 2];
+    const char *outputPath = argv[optind + 3];
+    const int inputFd = open(inputPath, O_RDONLY | O_CLOEXEC);
+    if (inputFd < 0)
+    {
+        std::cerr << "Unable to open " << inputPath << " (errno: " << errno << ")" << std::endl;
+        return 1;
+    }
+    const int outputFd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (outputFd < 0)
+    {
+        std::cerr << "Unable to open " << outputPath << " (errno: " << errno << ")" << std::endl;
+        return 1;
+    }
+
+    const int sock = connectService(argv[optind]);
+    if (sock < 0)
+        return 1;
+    HuffdResponse response;
+    if (!sendRequest(sock, request, inputFd, outputFd) || !recvResponse(sock, response))
+    {
+        std::cerr << "Request to " << argv[optind] << " failed" << std::endl;
+        return 1;
+    }
+    if (response.status != 0)
+    {
+        std::cerr << "Request failed: " << std::strerror(response.status) << std::endl;
+        return 1;
+    }
+    std::cout << "Bytes In : " << response.bytesIn << "\n";
+    std::cout << "Bytes Out: " << response.bytesOut << std::endl;
+    return 0;
+}
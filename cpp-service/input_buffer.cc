@@ -0,0 +1,48 @@
+#include "input_buffer.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t READ_CHUNK_LEN = 64 * 1024;
+
+int InputBuffer::load(int fd, size_t maxLen)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return errno;
+
+    // Regular files are read in one go, the size is only a hint since the file can change while it's read. The byte
+    // past it lets the read that finds the end of file go without growing the buffer.
+    size_t bufLen = READ_CHUNK_LEN;
+    const off_t offset = S_ISREG(st.st_mode) ? lseek(fd, 0, SEEK_CUR) : -1;
+    if (offset >= 0 && offset < st.st_size)
+    {
+        if (static_cast<uint64_t>(st.st_size - offset) > maxLen)
+            return EFBIG;
+        bufLen = static_cast<size_t>(st.st_size - offset) + 1;
+    }
+
+    m_Data.resize(bufLen);
+    size_t len = 0;
+    for (;;)
+    {
+        if (len == m_Data.size())
+        {
+            if (len > maxLen)
+                return EFBIG;
+            m_Data.resize(len + READ_CHUNK_LEN);
+        }
+        const ssize_t bytesRead = read(fd, m_Data.data() + len, m_Data.size() - len);
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead < 0)
+            return errno;
+        if (bytesRead == 0)
+            break;
+        len += static_cast<size_t>(bytesRead);
+    }
+    m_Data.resize(len);
+    return 0;
+}
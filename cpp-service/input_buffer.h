@@ -0,0 +1,30 @@
+#ifndef INPUT_BUFFER_H
+#define INPUT_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief The whole remaining input of an fd in memory
+ *
+ * The input is read until end of file rather than mapped. Clients own the files they pass, a mapped file that
+ * shrinks while a request runs would kill the service with SIGBUS. Inputs longer than `maxLen` are rejected before
+ * they are read in full.
+ */
+class InputBuffer
+{
+  public:
+    InputBuffer() : m_Data() {}
+    InputBuffer(const InputBuffer &) = delete;
+
+    // Returns 0 or an errno value, EFBIG when the input is longer than maxLen
+    int load(int fd, size_t maxLen);
+
+    const char *data() const { return m_Data.data(); }
+    size_t size() const { return m_Data.size(); }
+
+  private:
+    std::vector<char> m_Data;
+};
+
+#endif // INPUT_BUFFER_H
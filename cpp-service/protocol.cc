@@ -0,0 +1,131 @@
+#include "protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const size_t REQUEST_FDS = 2;
+
+/**
+ * @brief Connect to the service listening on `socketPath`
+ *
+ * @returns the connected socket or -1
+ */
+int connectService(const char *socketPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (std::strlen(socketPath) >= sizeof(addr.sun_path))
+    {
+        std::cerr << "Socket path is too long: " << socketPath << std::endl;
+        return -1;
+    }
+    std::strcpy(addr.sun_path, socketPath);
+
+    const int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+    {
+        std::cerr << "Unable to create socket (errno: " << errno << ")" << std::endl;
+        return -1;
+    }
+    if (connect(sock, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        std::cerr << "Unable to connect to " << socketPath << " (errno: " << errno << ")" << std::endl;
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool sendRequest(int sock, const HuffdRequest &request, int inputFd, int outputFd)
+{
+    const int fds[REQUEST_FDS] = {inputFd, outputFd};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    iovec iov{const_cast<HuffdRequest *>(&request), sizeof(request)};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    while ((sent = sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR)
+        ;
+    return sent == static_cast<ssize_t>(sizeof(request));
+}
+
+/**
+ * @brief Receive the next request of a connection with its two fds, which the caller has to close
+ *
+ * @param[out] eof - Set when the other side closed the connection
+ * @returns false on end of file, on errors and on malformed messages, any received fds are closed then
+ */
+bool recvRequest(int sock, HuffdRequest &request, int &inputFd, int &outputFd, bool &eof)
+{
+    int fds[REQUEST_FDS] = {-1, -1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    iovec iov{&request, sizeof(request)};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    while ((received = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR)
+        ;
+    eof = received == 0;
+    if (received <= 0)
+        return false;
+
+    size_t numFds = 0;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        numFds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        std::memcpy(fds, CMSG_DATA(cmsg), std::min(numFds, REQUEST_FDS) * sizeof(int));
+    }
+
+    if (received != sizeof(request) || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || numFds != REQUEST_FDS ||
+        request.magic != HUFFD_MAGIC)
+    {
+        std::cerr << "Malformed request" << std::endl;
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+        return false;
+    }
+    inputFd = fds[0];
+    outputFd = fds[1];
+    return true;
+}
+
+bool sendResponse(int sock, const HuffdResponse &response)
+{
+    ssize_t sent;
+    while ((sent = send(sock, &response, sizeof(response), MSG_NOSIGNAL)) < 0 && errno == EINTR)
+        ;
+    return sent == static_cast<ssize_t>(sizeof(response));
+}
+
+bool recvResponse(int sock, HuffdResponse &response)
+{
+    ssize_t received;
+    while ((received = recv(sock, &response, sizeof(response), 0)) < 0 && errno == EINTR)
+        ;
+    return received == static_cast<ssize_t>(sizeof(response)) && response.magic == HUFFD_MAGIC;
+}
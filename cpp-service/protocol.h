@@ -0,0 +1,65 @@
+#ifndef HUFFD_PROTOCOL_H
+#define HUFFD_PROTOCOL_H
+
+#include <cstdint>
+
+// "HUFD" read as a little endian uint32_t
+static const uint32_t HUFFD_MAGIC = 0x44465548;
+
+enum class HuffdOp : uint8_t
+{
+    // Input is the original data, output is a block format stream
+    Encode = 0,
+    // Input is a stream written by `encoding`, output is the original data
+    Decode = 1,
+};
+
+// Same values as BlockBackend of the encoder
+enum class HuffdBackend : uint8_t
+{
+    Huffman = 0,
+    Tans = 1,
+    Auto = 2,
+};
+
+// Encode options, the same as the flags of `encoding`
+static const uint16_t HUFFD_FLAG_CRC32C = 0x1;   // -c
+static const uint16_t HUFFD_FLAG_CONTEXTS = 0x2; // -C
+static const uint16_t HUFFD_FLAG_DIGRAMS = 0x4;  // -d
+static const uint16_t HUFFD_FLAG_SAMPLED = 0x8;  // -f
+static const uint16_t HUFFD_KNOWN_FLAGS = 0xF;
+
+/**
+ * @brief One SOCK_SEQPACKET message, sent with the input fd and the output fd of the request attached
+ *
+ * The service reads the whole input fd from its current position and writes the result to the output fd, so no
+ * data goes through the socket.
+ */
+struct HuffdRequest
+{
+    uint32_t magic;
+    uint8_t op;
+    uint8_t backend;
+    uint16_t flags;
+};
+
+/**
+ * @brief Answer to every request, in the order the requests were sent on the connection
+ */
+struct HuffdResponse
+{
+    uint32_t magic;
+    // 0 or an errno value, EINVAL when the request or the encoded input is invalid
+    int32_t status;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+};
+
+int connectService(const char *socketPath);
+
+bool sendRequest(int sock, const HuffdRequest &request, int inputFd, int outputFd);
+bool recvRequest(int sock, HuffdRequest &request, int &inputFd, int &outputFd, bool &eof);
+bool sendResponse(int sock, const HuffdResponse &response);
+bool recvResponse(int sock, HuffdResponse &response);
+
+#endif // HUFFD_PROTOCOL_H